@@ -1,21 +1,63 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
 #include "simprop.h"
 
 using namespace simprop;
 
-void testSpectrumEvolution(double zMax, std::string filename, size_t N = 100) {
+void testSpectrumEvolution(double zMax, std::string filename, size_t N = 100,
+                           size_t nThreads = 1, std::string libraryFilename = "") {
+  // 0 threads means one per hardware thread, resolved here so that the SOPHIA workers match
+  if (nThreads == 0) nThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
   RandomNumberGenerator rng = utils::RNG<double>(69);
   auto cmb = std::make_shared<photonfields::CMB>();
   auto cosmo = std::make_shared<cosmo::Cosmology>();
   auto sim = evolutors::SingleProtonEvolutor(rng);
   sim.addCosmology(cosmo);
+  sim.setThreads(nThreads);
   auto adiabatic = std::make_shared<losses::AdiabaticContinuousLosses>(cosmo);
   auto pp = std::make_shared<losses::PairProductionLosses>(cmb);
   pp->doCaching();
   sim.addLosses({adiabatic, pp});
+  sim.doCachingLosses();
   auto ppp = std::make_shared<interactions::PhotoPionProductionSophia>(cmb);
   ppp->doCaching();
+  if (nThreads > 1) ppp->setWorkers(nThreads);
+  if (!libraryFilename.empty()) {
+    // the SOPHIA event library is generated once and reused by the following runs
+    if (utils::fileExists(libraryFilename)) {
+      ppp->setEventLibrary(
+          interactions::PhotoPionProductionSophia::loadEventLibrary(libraryFilename));
+    } else {
+      auto library = interactions::PhotoPionProductionSophia::generateEventLibrary();
+      library->save(libraryFilename);
+      ppp->setEventLibrary(library);
+    }
+  }
   sim.addInteractions({ppp});
 
+  // finished particles are written as they are retired, the stack only holds the primaries
+  auto protons = std::make_shared<observers::FilterObserver>(
+      [](const Particle& particle) {
+        return particle.getPid() == proton && particle.getRedshift() < 1e-20;
+      },
+      std::vector<std::shared_ptr<observers::Observer>>{
+          std::make_shared<observers::FileObserver>(filename)});
+  auto neutrinos = std::make_shared<observers::FilterObserver>(
+      observers::IsSpecies({neutrino_e, neutrino_mu, antineutrino_e, antineutrino_mu}),
+      std::vector<std::shared_ptr<observers::Observer>>{std::make_shared<observers::FileObserver>(
+          "neutrinos.txt", [](const Particle& particle) {
+            std::ostringstream line;
+            line << getPidName(particle.getPid()) << " " << particle.getRedshift() << " "
+                 << particle.getGamma() / SI::eV << " " << particle.getWeight();
+            return line.str();
+          })});
+  sim.addObservers({protons, neutrinos});
+  auto stats = std::make_shared<evolutors::RunStats>(60.);
+  sim.addRunStats(stats);
+
   const auto minEnergy = 1e17 * SI::eV;
   const auto maxEnergy = 1e23 * SI::eV;
   const auto slope = 2.6;
@@ -25,30 +67,28 @@ void testSpectrumEvolution(double zMax, std::string filename, size_t N = 100) {
   auto builder = SourceEvolutionBuilder(proton, {GammaRange, zRange, slope, m}, cosmo, N);
   auto stack = builder.build(rng);
   sim.run(stack);
-
-  utils::OutputFile out(filename);
-  for (const auto& particle : stack) {
-    if (particle.getPid() == proton && particle.getRedshift() < 1e-20) out << particle << "\n";
-  }
-
-  utils::OutputFile outNus("neutrinos.txt");
-  for (const auto& particle : stack) {
-    if (particle.getPid() == neutrino_e || particle.getPid() == neutrino_mu ||
-        particle.getPid() == antineutrino_e || particle.getPid() == antineutrino_mu) {
-      auto name = getPidName(particle.getPid());
-      auto z = particle.getRedshift();
-      auto E = particle.getGamma() / SI::eV;
-      auto w = particle.getWeight();
-      outNus << name << " " << z << " " << E << " " << w << "\n";
-    }
-  }
+  stats->dump("runstats.json");
 }
 
-int main() {
+int main(int argc, char* argv[]) {
   try {
     utils::startup_information();
     utils::Timer timer("main timer");
-    testSpectrumEvolution(3.0, "SimProp_spectrum_a2.6_z3.0_m0_sophia.txt", 100000);
+    // usage: evolve [nThreads] [--event-library file], 0 uses all hardware threads. SOPHIA is
+    // called for every interaction unless an event library is given, it is generated if missing
+    size_t nThreads = 1;
+    std::string libraryFilename;
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      if (arg == "--event-library") {
+        if (i + 1 == argc) throw std::invalid_argument("--event-library needs a filename");
+        libraryFilename = argv[++i];
+      } else {
+        nThreads = std::stoul(arg);
+      }
+    }
+    testSpectrumEvolution(3.0, "SimProp_spectrum_a2.6_z3.0_m0_sophia.txt", 100000, nThreads,
+                          libraryFilename);
   } catch (const std::exception& e) {
     LOGE << "exception caught with message: " << e.what();
   }
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "simprop.h"
+
+using namespace simprop;
+
+template <typename Kernel>
+double timeKernel(const Kernel& kernel, size_t nRepeat, size_t nPoints) {
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < nRepeat; ++i) kernel();
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         (double)(nRepeat * nPoints);
+}
+
+template <typename Scalar, typename Batch>
+void benchmark(const std::string& name, const std::vector<double>& x, const Scalar& scalar,
+               const Batch& batch) {
+  const size_t nRepeat = 2000;
+  std::vector<double> values(x.size());
+  double sum = 0;
+  auto runScalar = [&]() {
+    for (size_t i = 0; i < x.size(); ++i) values[i] = scalar(x[i]);
+    sum += values.back();
+  };
+  auto runBatch = [&]() {
+    batch(x, values);
+    sum += values.back();
+  };
+  const auto tScalar = timeKernel(runScalar, nRepeat, x.size());
+  const auto tBatch = timeKernel(runBatch, nRepeat, x.size());
+  LOGD << "checksum " << sum;
+
+  double maxDeviation = 0;
+  batch(x, values);
+  for (size_t i = 0; i < x.size(); ++i) {
+    const auto reference = scalar(x[i]);
+    if (reference != 0.)
+      maxDeviation = std::max(maxDeviation, std::fabs(values[i] / reference - 1.));
+  }
+  LOGI << name << " scalar : " << tScalar << " ns, batch : " << tBatch << " ns, speedup "
+       << tScalar / tBatch << ", max relative deviation " << maxDeviation;
+}
+
+void benchmark_batch_kernels() {
+  const size_t N = 1024;
+  const auto k = utils::LogAxis<double>(1., 1e6, N);
+  benchmark(
+      "pair production phi", k, [](double x) { return losses::phi(x); },
+      [](const std::vector<double>& x, std::vector<double>& v) { losses::phi(x, v); });
+
+  const auto epsPrime = utils::LogAxis<double>(0.1 * SI::GeV, 1e5 * SI::GeV, N);
+  benchmark(
+      "photo-pion inelasticity", epsPrime, [](double x) { return losses::inelasticity(x); },
+      [](const std::vector<double>& x, std::vector<double>& v) { losses::inelasticity(x, v); });
+
+  const auto sThreshold = 4. * pow2(SI::electronMassC2);
+  const auto s = utils::LogAxis<double>(0.5 * sThreshold, 1e5 * sThreshold, N);
+  benchmark(
+      "Breit-Wheeler sigma", s, [](double x) { return BreitWheeler::sigmaInCoMFrame(x); },
+      [](const std::vector<double>& x, std::vector<double>& v) {
+        BreitWheeler::sigmaInCoMFrame(x, v);
+      });
+
+  const auto cmb = std::make_shared<photonfields::CMB>();
+  const auto eps = utils::LogAxis<double>(1e-5 * SI::eV, 0.1 * SI::eV, N);
+  benchmark(
+      "CMB density", eps, [&](double x) { return cmb->density(x, 1.); },
+      [&](const std::vector<double>& x, std::vector<double>& v) { cmb->batchDensity(x, 1., v); });
+  benchmark(
+      "CMB I_gamma", eps, [&](double x) { return cmb->I_gamma(x, 1.); },
+      [&](const std::vector<double>& x, std::vector<double>& v) { cmb->batchIgamma(x, 1., v); });
+}
+
+int main() {
+  try {
+    utils::startup_information();
+    utils::Timer timer("main timer");
+    benchmark_batch_kernels();
+  } catch (const std::exception& e) {
+    LOGE << "exception caught with message: " << e.what();
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cmath>
+
+#include "simprop.h"
+
+using namespace simprop;
+
+template <typename Sampler>
+double timeSampling(const Sampler& sampler, size_t N) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  double sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < N; ++i) sum += sampler(rng(), std::exp(1. + 8. * rng()) * SI::GeV2);
+  const auto stop = std::chrono::steady_clock::now();
+  LOGD << "checksum " << sum / SI::GeV2;
+  return std::chrono::duration<double, std::nano>(stop - start).count() / (double)N;
+}
+
+void benchmark_sampled_s() {
+  const auto cmb = std::make_shared<photonfields::CMB>();
+  const auto ppp = std::make_shared<interactions::PhotoPionProduction>(cmb);
+  const size_t N = 100000;
+  for (auto nucleon : {proton, neutron}) {
+    auto table = [&](double r, double sMax) { return ppp->sampleS(r, nucleon, sMax); };
+    auto exact = [&](double r, double sMax) { return ppp->sampleSExact(r, nucleon, sMax); };
+    LOGI << getPidName(nucleon) << " table lookup : " << timeSampling(table, N) << " ns";
+    LOGI << getPidName(nucleon) << " root finding : " << timeSampling(exact, N) << " ns";
+
+    double maxDeviation = 0;
+    RandomNumberGenerator rng = utils::RNG<double>(5678);
+    for (size_t i = 0; i < N; ++i) {
+      const auto r = rng();
+      const auto sMax = std::exp(1. + 8. * rng()) * SI::GeV2;
+      const auto s = ppp->sampleSExact(r, nucleon, sMax);
+      maxDeviation = std::max(maxDeviation, std::fabs(ppp->sampleS(r, nucleon, sMax) / s - 1.));
+    }
+    LOGI << getPidName(nucleon) << " max relative deviation : " << maxDeviation;
+  }
+}
+
+int main() {
+  try {
+    utils::startup_information();
+    utils::Timer timer("main timer");
+    benchmark_sampled_s();
+  } catch (const std::exception& e) {
+    LOGE << "exception caught with message: " << e.what();
+  }
+  return EXIT_SUCCESS;
+}
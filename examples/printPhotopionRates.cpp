@@ -53,7 +53,7 @@ void plot_sampled_epsilon() {
   const auto ebl = std::make_shared<photonfields::Dominguez2011PhotonField>();
   LOGI << "EBL min photon energy = " << ebl->getMinPhotonEnergy() / SI::eV;
   LOGI << "EBL max photon energy = " << ebl->getMaxPhotonEnergy() / SI::eV;
-  const auto xs = std::make_shared<xsecs::PhotoPionXsec>();
+  const auto xs = utils::DataRegistry::get<xsecs::PhotoPionXsec>();
   {
     const auto photonEnergies = utils::LogAxis<double>(1e-3 * SI::eV, 1e1 * SI::eV, 1000);
     std::vector<double> redshifts = {0., 1., 2., 3.};
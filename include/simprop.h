@@ -14,10 +14,23 @@
 #include "simprop/energyLosses/BGG2006ContinuousLosses.h"
 #include "simprop/energyLosses/PairProductionLosses.h"
 #include "simprop/energyLosses/PhotoPionContinuousLosses.h"
+#include "simprop/evolutors/Checkpoint.h"
+#include "simprop/evolutors/EnsembleEvolutor.h"
+#include "simprop/evolutors/LossesCharacteristicTable.h"
+#include "simprop/evolutors/OpacityTable.h"
+#include "simprop/evolutors/RateMajorantTable.h"
+#include "simprop/evolutors/RunStats.h"
 #include "simprop/evolutors/SingleProtonEvolutor.h"
+#include "simprop/evolutors/WeightWindow.h"
 #include "simprop/interactions/PhotoDisintegration.h"
 #include "simprop/interactions/PhotoPionProduction.h"
 #include "simprop/interactions/PhotoPionProductionSophia.h"
+#include "simprop/interactions/SophiaEventLibrary.h"
+#include "simprop/interactions/SophiaWorkerPool.h"
+#include "simprop/observers/FileObserver.h"
+#include "simprop/observers/FilterObserver.h"
+#include "simprop/observers/HistogramObserver.h"
+#include "simprop/observers/Observer.h"
 #include "simprop/particleStacks/SingleParticleBuilder.h"
 #include "simprop/particleStacks/SingleSourceBuilder.h"
 #include "simprop/particleStacks/SourceEvolutionBuilder.h"
@@ -32,6 +45,7 @@
 #include "simprop/utils/numeric.h"
 #include "simprop/utils/progressbar.h"
 #include "simprop/utils/random.h"
+#include "simprop/utils/registry.h"
 #include "simprop/utils/timer.h"
 
 #endif  // INCLUDE_SIMPROP_H
@@ -49,6 +49,7 @@ class Particle {
   const bool isNucleus() const { return pidIsNucleus(m_pid); }
   const bool isActive() const { return m_doPropagate; }
 
+  void setWeight(double weight) { m_weight = weight; }
   void deactivate() { m_doPropagate = false; }
   void activate() { m_doPropagate = true; }
 
@@ -1,10 +1,14 @@
 #ifndef SIMPROP_XSECS_BREITWHEELER_H
 #define SIMPROP_XSECS_BREITWHEELER_H
 
+#include <vector>
+
 namespace simprop {
 namespace BreitWheeler {
 
 double sigmaInCoMFrame(const double &s);
+// batch version filling values[i] at s[i]
+void sigmaInCoMFrame(const std::vector<double> &s, std::vector<double> &values);
 double sigma(const double &eGamma, const double &eBkg, const double &mu);
 
 }  // namespace BreitWheeler
@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "simprop/core/common.h"
 #include "simprop/crossSections/CrossSection.h"
 
 namespace simprop {
@@ -23,6 +24,8 @@ class TalysChannel {
   virtual ~TalysChannel() = default;
   void loadXsecMaps(const std::string filename);
   double get(PID pid, double eps) const;
+  Range getEnergyRange() const { return {m_energyAxis.front(), m_energyAxis.back()}; }
+  std::vector<PID> getPids() const;
 
  protected:
   void buildEnergyAxis();
@@ -45,6 +48,11 @@ class PhotoDisintegrationTalysXsec final : public CrossSection {
 
   double getAtEpsPrime(PID pid, double eps) const override;
   double getEpsPrimeThreshold() const override;
+
+  // the cross sections vanish outside this range
+  Range getEpsPrimeRange() const;
+  // isotopes with at least one tabulated channel
+  std::vector<PID> getPids() const;
 };
 
 }  // namespace xsecs
@@ -2,6 +2,7 @@
 #define SIMPROP_XSECS_PHOTOPIONXSECS_H
 
 #include <string>
+#include <vector>
 
 #include "simprop/crossSections/CrossSection.h"
 #include "simprop/utils/lookupContainers.h"
@@ -17,6 +18,18 @@ class PhotoPionXsec final : public CrossSection {
   utils::LookupArray<2850> m_neutron_sigma;
   utils::LookupArray<2850> m_neutron_phi;
 
+  // inverse of phi(s), s on an equidistant ln phi grid built at load time
+  struct InversePhi {
+    double sZero = 0;  // last tabulated s with phi = 0
+    double phiMin = 0;
+    double lnPhiMin = 0;
+    double dlnPhi = 0;
+    std::vector<double> s;
+  };
+  static constexpr size_t m_inversePhiSize = 4096;
+  InversePhi m_proton_inversePhi;
+  InversePhi m_neutron_inversePhi;
+
  public:
   PhotoPionXsec();
   virtual ~PhotoPionXsec() = default;
@@ -25,8 +38,10 @@ class PhotoPionXsec final : public CrossSection {
 
   double getAtS(PID pid, double s) const;
   double getPhiAtS(PID pid, double s) const;
+  double getSAtPhi(PID pid, double phi) const;
 
  private:
+  static InversePhi buildInversePhi(const std::vector<double>& s, const std::vector<double>& phi);
   double getProtonXsec(double s) const;
   double getNeutronXsec(double s) const;
 };
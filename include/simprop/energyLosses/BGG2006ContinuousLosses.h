@@ -1,6 +1,9 @@
 #ifndef SIMPROP_LOSSES_BGG2006_CONTINUOUS_H
 #define SIMPROP_LOSSES_BGG2006_CONTINUOUS_H
 
+#include <memory>
+#include <string>
+
 #include "simprop/energyLosses/ContinuousLosses.h"
 #include "simprop/utils/lookupContainers.h"
 
@@ -11,7 +14,7 @@ class BGG2006ContinuousLosses final : public ContinuousLosses {
  protected:
   // Berezinsky, Gazizov & Grigorieva, 2006, PRD, vol. 74, Issue 4, id. 043005
   const std::string totalLossesFilename = "data/losses_pair_BGG2006.txt";
-  utils::LookupArray<501> m_totalLosses;
+  std::shared_ptr<const utils::LookupArray<501>> m_totalLosses;
 
  public:
   BGG2006ContinuousLosses();
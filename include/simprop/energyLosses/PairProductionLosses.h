@@ -1,6 +1,8 @@
 #ifndef SIMPROP_LOSSES_PAIRPRODUCTION_H
 #define SIMPROP_LOSSES_PAIRPRODUCTION_H
 
+#include <vector>
+
 #include "simprop/energyLosses/ContinuousLosses.h"
 #include "simprop/photonFields/PhotonField.h"
 #include "simprop/utils/lookupContainers.h"
@@ -8,11 +10,18 @@
 namespace simprop {
 namespace losses {
 
+// phi function of the pair-production energy loss rate, scalar and batch versions
+double phi(double k);
+void phi(const std::vector<double>& k, std::vector<double>& values);
+
 class PairProductionLosses final : public ContinuousLosses {
  protected:
   photonfields::PhotonFields m_photonFields;
   utils::LookupTable<2000, 200> m_betaProtons;
+  // beta at z = 0 over ln Gamma (1+z), used instead when all the fields are self-similar
+  utils::LookupArray<2000> m_scaledBetaProtons;
   bool m_doCaching = false;
+  bool m_isSelfSimilar = false;
 
  public:
   PairProductionLosses(const std::shared_ptr<photonfields::PhotonField>& photonField);
@@ -3,27 +3,49 @@
 #define SIMPROP_ENERGYLOSSES_PHOTOPIONCONTINUOUSLOSSES_H_
 
 #include <memory>
+#include <vector>
 
 #include "simprop/crossSections/PhotoPionXsecs.h"
 #include "simprop/energyLosses/ContinuousLosses.h"
+#include "simprop/interactions/PhotoPionProduction.h"
 #include "simprop/photonFields/PhotonField.h"
+#include "simprop/utils/lookupContainers.h"
 
 namespace simprop {
 namespace losses {
 
 double inelasticity(double epsPrime);
+void inelasticity(const std::vector<double>& epsPrime, std::vector<double>& values);
 
 class PhotoPionContinuousLosses final : public ContinuousLosses {
  protected:
   photonfields::PhotonFields m_photonFields;
-  xsecs::PhotoPionXsec m_xs;
+  std::shared_ptr<const xsecs::PhotoPionXsec> m_xs;
+  std::shared_ptr<const interactions::PhotoPionProduction> m_interaction;
+  utils::LookupTable<2000, 200> m_betaProtons;
+  utils::LookupTable<2000, 200> m_betaNeutrons;
+  // beta at z = 0 over ln Gamma (1+z), used instead when all the fields are self-similar
+  utils::LookupArray<2000> m_scaledBetaProtons;
+  utils::LookupArray<2000> m_scaledBetaNeutrons;
+  bool m_doCaching = false;
+  bool m_isSelfSimilar = false;
 
  public:
   PhotoPionContinuousLosses(const std::shared_ptr<photonfields::PhotonField>& photonField);
   PhotoPionContinuousLosses(const photonfields::PhotonFields& photonFields);
+  // losses on the photon field of the interaction, read from the tables it fills together with
+  // its rates once it is cached
+  PhotoPionContinuousLosses(
+      const std::shared_ptr<const interactions::PhotoPionProduction>& interaction);
   virtual ~PhotoPionContinuousLosses() = default;
+  // tabulate the nucleon losses summed over the photon fields, nuclei are superposed as Z protons
+  // and A - Z neutrons
+  void doCaching();
 
   double beta(PID pid, double Gamma, double z = 0) const override;
+
+ protected:
+  double computeBeta(PID pid, double Gamma, double z) const;
 };
 
 }  // namespace losses
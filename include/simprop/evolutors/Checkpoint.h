@@ -0,0 +1,33 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_CHECKPOINT_H
+#define SIMPROP_EVOLUTORS_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "simprop/core/particle.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Snapshot of an evolutor run taken once all the primaries before nextPrimary are observed,
+// stored in a compact binary file. The finished particles are in the observers, whose states
+// are saved, so that the file does not grow with the run.
+struct Checkpoint {
+  size_t nPrimaries = 0;
+  size_t nextPrimary = 0;
+  uint64_t seed = 0;
+  // primaries still to be evolved, starting from nextPrimary
+  ParticleStack pending;
+  std::string rngState;
+  std::vector<std::string> observersState;
+
+  void save(const std::string& filename) const;
+  static Checkpoint load(const std::string& filename);
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_CHECKPOINT_H
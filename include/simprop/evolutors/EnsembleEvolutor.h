@@ -0,0 +1,85 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_ENSEMBLEEVOLUTOR_H_
+#define SIMPROP_EVOLUTORS_ENSEMBLEEVOLUTOR_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "simprop/evolutors/SingleProtonEvolutor.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Evolves the whole stack in lockstep. The active particles are stored as structure of arrays
+// and advanced in blocks using (ln Gamma, z) tables shared by all species, particles that
+// interact are peeled off to the scalar finalState path. Particles outside the tables, or of a
+// species without tables, are evolved with the SingleProtonEvolutor algorithm. Every particle
+// draws from the counter-based stream of its primary, so that a run depends only on the seed.
+class EnsembleEvolutor final : public SingleProtonEvolutor {
+ public:
+  EnsembleEvolutor(RandomNumberGenerator& rng);
+  virtual ~EnsembleEvolutor() = default;
+
+  void setBlockSize(size_t blockSize) { m_blockSize = std::max(blockSize, size_t(1)); }
+  // tabulate the ensemble losses and rates of the given species, the species of the primaries
+  // are tabulated at the start of each run if missing
+  void doCachingEnsemble(const std::vector<PID>& species = {proton});
+  void run(ParticleStack& stack) override;
+
+ protected:
+  void dropTables(bool isLosses, bool isRates) override;
+  size_t findSpeciesIndex(PID pid) const;
+  void push(const Particle& particle, size_t iPrimary, ParticleStack& finished);
+  Particle pull(size_t i) const;
+  void stepBlock(size_t begin, size_t end, ParticleStack& finished, ThreadStats* stats);
+  double invertLosses(size_t offset, double t, double value) const;
+  void compact();
+
+ protected:
+  size_t m_blockSize = 256;
+
+  // grid shared by all species, tables are stored as [species][ln Gamma][z]
+  size_t m_lnGammaSize = 0;
+  size_t m_zSize = 0;
+  double m_lnGammaMin = 0;
+  double m_dlnGamma = 0;
+  double m_dz = 0;
+  std::vector<PID> m_species;
+  std::vector<double> m_lossesGrid;
+  std::vector<double> m_ratesGrid;
+  // optional sampling tables of each species, resolved at the start of a run
+  std::vector<const OpacityTable*> m_speciesOpacities;
+  std::vector<const RateMajorantTable*> m_speciesMajorants;
+
+  // random stream of every primary, swapped into m_streamRng while one of its particles draws
+  std::vector<utils::Philox4x32> m_streams;
+  RandomNumberGenerator m_streamRng{uint64_t(0), uint64_t(0)};
+
+  // active set
+  std::vector<double> m_z;
+  std::vector<double> m_Gamma;
+  std::vector<double> m_weight;
+  std::vector<size_t> m_speciesIndex;
+  std::vector<size_t> m_primary;
+  std::vector<double> m_zOrigin;
+  std::vector<double> m_GammaOrigin;
+  std::vector<char> m_alive;
+
+  // particles left to the scalar path and their primaries
+  ParticleStack m_scalar;
+  std::vector<size_t> m_scalarPrimary;
+
+  // block scratch
+  std::vector<double> m_rateDtdz;
+  std::vector<double> m_lossesNow;
+  std::vector<double> m_zNext;
+  std::vector<double> m_tGamma;
+  std::vector<size_t> m_rowOffset;
+  std::vector<double> m_cumulativeRates;
+  std::vector<Particle> m_finalState;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_ENSEMBLEEVOLUTOR_H_
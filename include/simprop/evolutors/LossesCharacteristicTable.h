@@ -0,0 +1,51 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_LOSSESCHARACTERISTICTABLE_H_
+#define SIMPROP_EVOLUTORS_LOSSESCHARACTERISTICTABLE_H_
+
+#include <functional>
+#include <vector>
+
+#include "simprop/core/common.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Cumulative continuous losses at fixed Lorentz factor
+//   B(Gamma, z) = int_0^z beta(Gamma, z') dt/dz' dz'
+// tabulated on an equidistant (ln Gamma, z) grid, so that the Gamma evolution over a redshift
+// interval, Gamma_next = Gamma exp(B(Gamma, z_next) - B(Gamma, z_now)), and its inversion are
+// table lookups.
+class LossesCharacteristicTable {
+ public:
+  LossesCharacteristicTable(size_t lnGammaSize = 1000, size_t zSize = 1000);
+  virtual ~LossesCharacteristicTable() = default;
+
+  void cacheTable(const std::function<double(double, double)>& betaDtdz, Range GammaRange,
+                  Range zRange);
+
+  size_t getLnGammaSize() const { return m_lnGammaSize; }
+  size_t getRedshiftSize() const { return m_zSize; }
+  const std::vector<double>& data() const { return m_table; }
+
+  bool isInside(double Gamma, double z) const;
+  double get(double Gamma, double z) const;
+  double findRedshift(double Gamma, double value) const;
+
+ protected:
+  double getRow(size_t i, double t, size_t j) const;
+  void locateGamma(double Gamma, size_t& i, double& t) const;
+
+ protected:
+  size_t m_lnGammaSize;
+  size_t m_zSize;
+  Range m_lnGammaRange{0., 0.};
+  Range m_zRange{0., 0.};
+  double m_dlnGamma = 0;
+  double m_dz = 0;
+  std::vector<double> m_table;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_LOSSESCHARACTERISTICTABLE_H_
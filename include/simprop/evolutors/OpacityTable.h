@@ -0,0 +1,26 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_OPACITYTABLE_H_
+#define SIMPROP_EVOLUTORS_OPACITYTABLE_H_
+
+#include "simprop/evolutors/LossesCharacteristicTable.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Cumulative interaction opacity at fixed Lorentz factor
+//   tau(Gamma, z) = int_0^z rate(Gamma, z') dt/dz' dz'
+// summed over all the interactions, i.e. over all the photon fields. The interaction redshift
+// is sampled exactly by inverting tau(Gamma, z_now) - tau(Gamma, z_next) = -ln(1 - r).
+class OpacityTable : public LossesCharacteristicTable {
+ public:
+  using LossesCharacteristicTable::LossesCharacteristicTable;
+
+  // redshift interval to the interaction for the random number r, the largest double if the
+  // particle reaches the lower end of the table without interacting
+  double sampleRedshiftInterval(double Gamma, double z, double r) const;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_OPACITYTABLE_H_
@@ -0,0 +1,45 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_RATEMAJORANTTABLE_H_
+#define SIMPROP_EVOLUTORS_RATEMAJORANTTABLE_H_
+
+#include <functional>
+#include <vector>
+
+#include "simprop/core/common.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Upper bound of the interaction rate per unit redshift, rate |dt/dz|, on the cells of an
+// equidistant (ln Gamma, z) grid. The bound of a cell is the largest value found on a finer
+// grid of nodes inside it, enlarged by a safety factor, so that interaction candidates can be
+// sampled from it and thinned with the exact rate (null-collision or Woodcock tracking).
+class RateMajorantTable {
+ public:
+  RateMajorantTable(size_t lnGammaCells = 128, size_t zCells = 100, size_t subdivisions = 4,
+                    double safetyFactor = 1.1);
+  virtual ~RateMajorantTable() = default;
+
+  void cacheTable(const std::function<double(double, double)>& rateDtdz, Range GammaRange,
+                  Range zRange);
+
+  bool isInside(double Gamma, double z) const;
+  // bound at Gamma valid for all the redshifts in [zMin, zMax]
+  double get(double Gamma, double zMin, double zMax) const;
+
+ protected:
+  size_t m_lnGammaCells;
+  size_t m_zCells;
+  size_t m_subdivisions;
+  double m_safetyFactor;
+  Range m_lnGammaRange{0., 0.};
+  Range m_zRange{0., 0.};
+  double m_dlnGamma = 0;
+  double m_dz = 0;
+  std::vector<double> m_table;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_RATEMAJORANTTABLE_H_
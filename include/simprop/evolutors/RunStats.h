@@ -0,0 +1,120 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_RUNSTATS_H_
+#define SIMPROP_EVOLUTORS_RUNSTATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace simprop {
+namespace evolutors {
+
+// Counter written by a single thread and read by the reporter, relaxed loads and stores avoid
+// the cost of atomic read-modify-write instructions
+class StatsCounter {
+ public:
+  void add(uint64_t n = 1) {
+    m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+  void max(uint64_t n) {
+    if (n > m_value.load(std::memory_order_relaxed)) m_value.store(n, std::memory_order_relaxed);
+  }
+  uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> m_value{0};
+};
+
+// Counters and phase timers of one worker thread
+class ThreadStats {
+ public:
+  enum Phase { rates = 0, losses, finalState, nPhases };
+
+  explicit ThreadStats(size_t nChannels) : interactionsPerChannel(nChannels) {}
+
+  StatsCounter primaries;
+  StatsCounter steps;
+  StatsCounter rateEvaluations;
+  // null-collision candidates whose rate exceeded the tabulated majorant
+  StatsCounter majorantViolations;
+  StatsCounter secondaries;
+  StatsCounter rootFinderIterations;
+  StatsCounter peakStack;
+  std::vector<StatsCounter> interactionsPerChannel;
+  StatsCounter nanoseconds[nPhases];
+};
+
+// Accumulates the time spent in a phase, does nothing without statistics
+class PhaseTimer {
+ public:
+  PhaseTimer(ThreadStats* stats, ThreadStats::Phase phase) : m_stats(stats), m_phase(phase) {
+    if (m_stats) m_start = std::chrono::steady_clock::now();
+  }
+  ~PhaseTimer() { stop(); }
+  void stop() {
+    if (!m_stats) return;
+    const auto elapsed = std::chrono::steady_clock::now() - m_start;
+    m_stats->nanoseconds[m_phase].add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    m_stats = nullptr;
+  }
+
+ private:
+  ThreadStats* m_stats;
+  ThreadStats::Phase m_phase;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+// Statistics of an evolutor run: per-thread counters, a periodic report while the run is in
+// progress and a machine-readable summary at the end
+class RunStats {
+ public:
+  // seconds between two reports, 0 disables the periodic reports
+  explicit RunStats(double reportInterval = 60.);
+  virtual ~RunStats();
+
+  void start(size_t nThreads, size_t nChannels, size_t nPrimaries);
+  void stop();
+  ThreadStats* getThread(size_t id) { return m_threads.at(id).get(); }
+
+  void report() const;
+  // writes the summary as JSON in the output directory, phase times are summed over threads
+  void dump(const std::string& filename) const;
+
+  uint64_t getPrimaries() const;
+  uint64_t getSteps() const;
+  uint64_t getRateEvaluations() const;
+  uint64_t getMajorantViolations() const;
+  uint64_t getInteractions() const;
+  std::vector<uint64_t> getInteractionsPerChannel() const;
+  uint64_t getRootFinderIterations() const;
+  uint64_t getPeakStack() const;
+  double getPhaseTime(ThreadStats::Phase phase) const;
+  double getElapsedTime() const;
+  double getParticlesPerSecond() const;
+
+ protected:
+  uint64_t sum(StatsCounter ThreadStats::*counter) const;
+
+ protected:
+  double m_reportInterval;
+  size_t m_nPrimaries = 0;
+  std::vector<std::unique_ptr<ThreadStats>> m_threads;
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::time_point m_stop;
+  bool m_running = false;
+  std::thread m_reporter;
+  std::mutex m_reporterMutex;
+  std::condition_variable m_reporterWakeup;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_RUNSTATS_H_
@@ -3,11 +3,21 @@
 #define SIMPROP_EVOLUTORS_SINGLEPROTONEVOLUTORS_H
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "simprop/core/cosmology.h"
 #include "simprop/energyLosses/ContinuousLosses.h"
+#include "simprop/evolutors/Checkpoint.h"
+#include "simprop/evolutors/LossesCharacteristicTable.h"
+#include "simprop/evolutors/OpacityTable.h"
+#include "simprop/evolutors/RateMajorantTable.h"
+#include "simprop/evolutors/RunStats.h"
+#include "simprop/evolutors/WeightWindow.h"
 #include "simprop/interactions/Interaction.h"
+#include "simprop/observers/Observer.h"
 #include "simprop/particleStacks/Builder.h"
+#include "simprop/utils/lookupContainers.h"
 #include "simprop/utils/random.h"
 
 namespace simprop {
@@ -18,28 +28,118 @@ class SingleProtonEvolutor {
   SingleProtonEvolutor(RandomNumberGenerator& rng);
   virtual ~SingleProtonEvolutor() = default;
 
-  void addCosmology(std::shared_ptr<cosmo::Cosmology> cosmology) { m_cosmology = cosmology; }
+  // the cached tables derived from what is replaced are dropped and must be cached again
+  void addCosmology(std::shared_ptr<cosmo::Cosmology> cosmology) {
+    m_cosmology = cosmology;
+    dropTables(true, true);
+  }
   void addLosses(std::vector<std::shared_ptr<losses::ContinuousLosses>> losses) {
     m_continuousLosses = losses;
+    dropTables(true, false);
   }
   void addInteractions(std::vector<std::shared_ptr<interactions::Interaction>> interactions) {
     m_interactions = interactions;
+    dropTables(false, true);
+  }
+  // finished particles are streamed to the observers instead of being kept in the stack, the
+  // cascades are handed over whole and in primary order
+  void addObservers(std::vector<std::shared_ptr<observers::Observer>> observers) {
+    m_observers = observers;
+  }
+  // number of worker threads used by run, 0 means one per hardware thread
+  void setThreads(size_t nThreads) { m_nThreads = nThreads; }
+  // tabulate the summed beta of all the losses of the given species, read in place of the losses
+  void doCachingTotalLosses(const std::vector<PID>& species = {proton});
+  // tabulate the cumulative losses of the given species, replacing root finding in the steps
+  void doCachingLosses(const std::vector<PID>& species = {proton});
+  // tabulate an upper bound of the total rate of the given species, whose interactions are then
+  // sampled by null collisions: candidates drawn from the bound are accepted with probability
+  // rate / bound, so that the exact rates are evaluated only at the candidates
+  void doCachingRateMajorants(const std::vector<PID>& species = {proton});
+  // tabulate the cumulative opacity of the given species, from which the interaction redshift is
+  // sampled exactly instead of from the rate at the step start, takes precedence over majorants.
+  // The sampled dz_s is still bounded by the losses step dz_c, so the number of steps is set by
+  // the losses as before and only the rate evaluations are saved
+  void doCachingOpacities(const std::vector<PID>& species = {proton});
+  // roulette and splitting applied to the secondaries of every interaction
+  void addWeightWindow(std::shared_ptr<WeightWindow> weightWindow) {
+    m_weightWindow = weightWindow;
+  }
+  // counters and timers collected while running
+  void addRunStats(std::shared_ptr<RunStats> stats) { m_stats = stats; }
+  // seed of the per-primary random streams, drawn from the user generator at each run if not set
+  void setSeed(uint64_t seed) {
+    m_seed = seed;
+    m_hasSeed = true;
   }
-  void run(ParticleStack& stack);
+  uint64_t getSeed() const { return m_seed; }
+  // write a checkpoint every interval primaries once all the earlier ones are observed, the
+  // finished particles must go to observers as the checkpoint keeps only their states
+  void setCheckpoint(const std::string& filename, size_t interval = 1000);
+  virtual void run(ParticleStack& stack);
+  // continue from a checkpoint, the evolutor must be configured as in the interrupted run
+  void resume(const std::string& filename, ParticleStack& stack);
+  // evolve again the primary with the given index, reproducing its cascade in the last run
+  ParticleStack replay(const Particle& primary, size_t iPrimary) const;
 
  protected:
+  static bool IsActive(const Particle& particle);
+  virtual void dropTables(bool isLosses, bool isRates);
+  size_t resolveThreads(size_t nPrimaries) const;
+  // evolves the primaries of the stack, saving the checkpoint if one is given
+  void runParallel(ParticleStack& stack, size_t nThreads, Checkpoint* checkpoint = nullptr);
+  // the first nObserved primaries of the stack are observed, the others are saved as pending
+  void saveCheckpoint(Checkpoint& checkpoint, const ParticleStack& stack, size_t firstPrimary,
+                      size_t nObserved) const;
+  void evolveStack(ParticleStack& stack, RandomNumberGenerator& rng,
+                   ThreadStats* stats = nullptr) const;
+  void evolvePrimary(const Particle& primary, size_t iPrimary, ParticleStack& finished,
+                     ThreadStats* stats = nullptr) const;
+  // hands the particles to the observers and releases them, callers must not run concurrently
+  void observe(ParticleStack& particles) const;
+  const LossesCharacteristicTable* findLossesTable(const Particle& particle) const;
   double computeDeltaGamma(const Particle& particle, double deltaRedshift) const;
   double computeLossesRedshiftInterval(const Particle& particle) const;
-  double computeInteractionRedshiftInterval(const Particle& particle) const;
+  double computeRates(const Particle& particle, std::vector<double>& cumulativeRates) const;
+  double computeRates(const Particle& particle, double z,
+                      std::vector<double>& cumulativeRates) const;
+  double computeInteractionRedshiftInterval(const Particle& particle, double rate,
+                                            RandomNumberGenerator& rng) const;
+  const RateMajorantTable* findRateMajorant(const Particle& particle) const;
+  const OpacityTable* findOpacityTable(const Particle& particle) const;
+  // redshift interval to the first accepted candidate, larger than dzMax if there is none, in
+  // which case cumulativeRates is left unspecified
+  double sampleNullCollisions(const RateMajorantTable& majorant, const Particle& particle,
+                              double dzMax, std::vector<double>& cumulativeRates,
+                              RandomNumberGenerator& rng, ThreadStats* stats) const;
+  size_t sampleInteraction(const std::vector<double>& cumulativeRates,
+                           RandomNumberGenerator& rng) const;
   double totalLosses(PID pid, double Gamma, double z) const;
   double totalRate(PID pid, double Gamma, double z) const;
 
  protected:
+  static constexpr double minPropagatingGamma = 1e6;
+  static constexpr double minPropagatingRedshift = 1e-20;
+  static constexpr size_t secondariesCapacity = 64;
   const double deltaGammaCritical = 0.01;
+  const Range m_tablesGammaRange = {1e6, 1e14};
+  const Range m_tablesRedshiftRange = {0., 10.};
+  size_t m_nThreads = 1;
+  uint64_t m_seed = 0;
+  bool m_hasSeed = false;
   RandomNumberGenerator& m_rng;
   std::shared_ptr<cosmo::Cosmology> m_cosmology;
   std::vector<std::shared_ptr<losses::ContinuousLosses>> m_continuousLosses;
   std::vector<std::shared_ptr<interactions::Interaction>> m_interactions;
+  std::unordered_map<PID, utils::LookupTable<2000, 200>> m_totalLossesTables;
+  std::unordered_map<PID, LossesCharacteristicTable> m_lossesTables;
+  std::unordered_map<PID, RateMajorantTable> m_rateMajorants;
+  std::unordered_map<PID, OpacityTable> m_opacityTables;
+  std::vector<std::shared_ptr<observers::Observer>> m_observers;
+  std::shared_ptr<WeightWindow> m_weightWindow;
+  std::shared_ptr<RunStats> m_stats;
+  std::string m_checkpointFilename;
+  size_t m_checkpointInterval = 0;
 };
 
 }  // namespace evolutors
@@ -0,0 +1,45 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_EVOLUTORS_WEIGHTWINDOW_H_
+#define SIMPROP_EVOLUTORS_WEIGHTWINDOW_H_
+
+#include <vector>
+
+#include "simprop/core/common.h"
+#include "simprop/utils/random.h"
+
+namespace simprop {
+namespace evolutors {
+
+// Weight windows applied to the secondaries of every interaction. Below the window a particle
+// plays Russian roulette and survives with the survival weight, above the window it is split
+// into copies of equal weight. Both keep the expected weight, so the estimators stay unbiased.
+class WeightWindow {
+ public:
+  struct Window {
+    PID pid;
+    Range energyRange;
+    double lower;
+    double upper;
+    double survival;
+  };
+
+  WeightWindow(size_t maxSplitting = 10);
+  virtual ~WeightWindow() = default;
+
+  // the survival weight defaults to the middle of the window
+  void add(PID pid, Range energyRange, double lower, double upper, double survival = 0);
+  const Window* find(const Particle& particle) const;
+  void apply(std::vector<Particle>& particles, RandomNumberGenerator& rng) const;
+
+  // energy for massive particles, Gamma holds the energy of the massless ones
+  static double getParticleEnergy(const Particle& particle);
+
+ protected:
+  size_t m_maxSplitting;
+  std::vector<Window> m_windows;
+};
+
+}  // namespace evolutors
+}  // namespace simprop
+
+#endif  // SIMPROP_EVOLUTORS_WEIGHTWINDOW_H_
@@ -2,6 +2,7 @@
 #define SIMPROP_INTERACTIONS_INTERACTION_H
 
 #include <memory>
+#include <vector>
 
 #include "simprop/core/particle.h"
 #include "simprop/photonFields/PhotonField.h"
@@ -18,10 +19,17 @@ class Interaction {
   Interaction() {}
   Interaction(const std::shared_ptr<photonfields::PhotonField>& phField) : m_phField(phField) {}
   virtual ~Interaction() = default;
+  const std::shared_ptr<photonfields::PhotonField>& getPhotonField() const { return m_phField; }
   virtual double rate(PID pid, double Gamma, double z = 0) const = 0;
-  virtual std::vector<Particle> finalState(const Particle& incomingParticle,
-                                           double zInteractionPoint,
-                                           RandomNumberGenerator& rng) const = 0;
+  // appends the secondaries to a caller-owned buffer, which keeps its capacity across calls
+  virtual void finalState(const Particle& incomingParticle, double zInteractionPoint,
+                          RandomNumberGenerator& rng, std::vector<Particle>& secondaries) const = 0;
+  std::vector<Particle> finalState(const Particle& incomingParticle, double zInteractionPoint,
+                                   RandomNumberGenerator& rng) const {
+    std::vector<Particle> secondaries;
+    finalState(incomingParticle, zInteractionPoint, rng, secondaries);
+    return secondaries;
+  }
 };
 
 }  // namespace interactions
@@ -1,6 +1,11 @@
 #ifndef SIMPROP_INTERACTIONS_PHOTODISINTEGRATION_H
 #define SIMPROP_INTERACTIONS_PHOTODISINTEGRATION_H
 
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "simprop/crossSections/PhotoDisintegrationTalysXsecs.h"
 #include "simprop/interactions/Interaction.h"
 
@@ -9,17 +14,47 @@ namespace interactions {
 
 class PhotoDisintegration final : public Interaction {
  protected:
-  xsecs::PhotoDisintegrationTalysXsec m_xs;
+  std::shared_ptr<const xsecs::PhotoDisintegrationTalysXsec> m_xs;
+  // single-nucleon and alpha emission, the TALYS channels in the order of m_xs
+  static constexpr size_t m_nChannels = 2;
+  // ln rate tables of the TALYS isotopes, stored as [isotope][ln Gamma][z]
+  static constexpr size_t m_lnGammaSize = 321;
+  static constexpr size_t m_zSize = 201;
+  const Range m_lnGammaRange = {std::log(1e6), std::log(1e14)};
+  const Range m_zRange = {0., 10.};
+  std::vector<double> m_lnRates;
+  // dense index of the tabulated isotopes at A * (m_maxZ + 1) + Z, -1 if not tabulated
+  std::vector<int> m_isotopeIndex;
+  // channel alias tables on every m_branchingStride-th node of the rate grid, stored as
+  // [isotope][ln Gamma][z][channel]
+  static constexpr size_t m_branchingStride = 4;
+  static constexpr size_t m_branchingLnGammaSize = (m_lnGammaSize - 1) / m_branchingStride + 1;
+  static constexpr size_t m_branchingZSize = (m_zSize - 1) / m_branchingStride + 1;
+  std::vector<float> m_aliasProbability;
+  std::vector<uint8_t> m_alias;
+  int m_maxA = 0;
+  int m_maxZ = 0;
+  bool m_doCaching = false;
 
  public:
   PhotoDisintegration(const std::shared_ptr<photonfields::PhotonField>& phField);
   virtual ~PhotoDisintegration() = default;
+  void doCaching();
   double rate(PID pid, double Gamma, double z = 0) const override;
 
   double interactionLength(PID pid, double Gamma) const;
 
-  std::vector<Particle> finalState(const Particle& particle, double zInteractionPoint,
-                                   RandomNumberGenerator& rng) const override;
+  using Interaction::finalState;
+  void finalState(const Particle& particle, double zInteractionPoint, RandomNumberGenerator& rng,
+                  std::vector<Particle>& secondaries) const override;
+
+ protected:
+  int getIsotopeIndex(PID pid) const;
+  Range getLnEpsPrimeRange(double Gamma) const;
+  double getChannelXsec(PID pid, double epsPrime, size_t channel) const;
+  double computeRate(PID pid, double Gamma, double z) const;
+  double computeChannelRate(PID pid, double Gamma, double z, size_t channel) const;
+  size_t sampleChannel(double r, PID pid, double Gamma, double z) const;
 };
 
 }  // namespace interactions
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <utility>
 
 #include "simprop/core/units.h"
 #include "simprop/crossSections/PhotoPionXsecs.h"
@@ -15,29 +16,63 @@ namespace interactions {
 
 PID pickNucleon(double r, PID pid);
 
+// rate and energy-loss rate of a nucleus on one photon field, whose integrands differ only by the
+// inelasticity weight and are therefore integrated together over the same nodes to 1e-4
+std::pair<double, double> computeRateAndBeta(const xsecs::PhotoPionXsec& xs,
+                                             const photonfields::PhotonField& phField, PID pid,
+                                             double Gamma, double z);
+
 class PhotoPionProduction : public Interaction {
  protected:
   const double m_sThreshold = pow2(SI::protonMassC2 + SI::pionMassC2);
-  xsecs::PhotoPionXsec m_xs;
+  std::shared_ptr<const xsecs::PhotoPionXsec> m_xs;
   utils::LookupTable<2000, 200> m_rateProtons;
   utils::LookupTable<2000, 200> m_rateNeutrons;
+  // energy-loss rates filled together with the rates
+  utils::LookupTable<2000, 200> m_betaProtons;
+  utils::LookupTable<2000, 200> m_betaNeutrons;
+  // rates and energy-loss rates at z = 0 over ln Gamma (1+z), used instead on self-similar fields
+  utils::LookupArray<2000> m_scaledRateProtons;
+  utils::LookupArray<2000> m_scaledRateNeutrons;
+  utils::LookupArray<2000> m_scaledBetaProtons;
+  utils::LookupArray<2000> m_scaledBetaNeutrons;
+  // inverse CDF of the target photon energy, ln eps over (ln nucleon energy, z, u)
+  utils::LookupTable3D<71, 101, 201> m_epsProtons;
+  utils::LookupTable3D<71, 101, 201> m_epsNeutrons;
   bool m_doCaching = false;
+  bool m_doCachingEps = false;
+  bool m_isSelfSimilar = false;
+  bool m_doReferenceSampling = false;
 
  public:
   PhotoPionProduction(const std::shared_ptr<photonfields::PhotonField>& phField);
   virtual ~PhotoPionProduction() = default;
   void doCaching();
+  // opt-in tables of the inverse CDF of the target photon energy, two 71x101x201 tables (about
+  // 23 MB) whose quantiles deviate from sampleEpsExact by up to about 0.75%
+  void doCachingEps();
+  // sample s and eps with root finding also when tables are available, used as reference
+  void setReferenceSampling(bool doReferenceSampling) {
+    m_doReferenceSampling = doReferenceSampling;
+  }
 
   double rate(PID pid, double Gamma, double z = 0) const override;
+  // continuous energy-loss rate on the same photon field, see losses::PhotoPionContinuousLosses
+  double beta(PID pid, double Gamma, double z = 0) const;
   double sampleS(double r, PID pid, double sMax) const;
+  double sampleSExact(double r, PID pid, double sMax) const;
   double sampleEps(double r, PID nucleon, double nucleonEnergy, double z) const;
+  double sampleEpsExact(double r, PID nucleon, double nucleonEnergy, double z) const;
 
-  std::vector<Particle> finalState(const Particle& particle, double zInteractionPoint,
-                                   RandomNumberGenerator& rng) const override;
+  using Interaction::finalState;
+  void finalState(const Particle& particle, double zInteractionPoint, RandomNumberGenerator& rng,
+                  std::vector<Particle>& secondaries) const override;
 
  protected:
   double epsPdfIntegral(double photonEnergy, PID nucleon, double nucleonEnergy, double z) const;
-  double computeNucleusRate(PID pid, double Gamma, double z, size_t N = 10) const;
+  std::vector<double> computeEpsInverseCdf(PID nucleon, double nucleonEnergy, double z,
+                                           size_t size) const;
+  double computeNucleusRate(PID pid, double Gamma, double z) const;
 };
 
 }  // namespace interactions
@@ -1,17 +1,43 @@
 #ifndef SIMPROP_INTERACTIONS_PHOTOPIONPRODUCTIONSOPHIA_H
 #define SIMPROP_INTERACTIONS_PHOTOPIONPRODUCTIONSOPHIA_H
 
+#include <memory>
+#include <string>
+
 #include "simprop/interactions/PhotoPionProduction.h"
+#include "simprop/interactions/SophiaEventLibrary.h"
+#include "simprop/interactions/SophiaWorkerPool.h"
 
 namespace simprop {
 namespace interactions {
 
 class PhotoPionProductionSophia final : public PhotoPionProduction {
+ protected:
+  std::shared_ptr<const SophiaEventLibrary> m_library;
+  std::shared_ptr<SophiaWorkerPool> m_workers;
+
  public:
   PhotoPionProductionSophia(const std::shared_ptr<photonfields::PhotonField>& phField);
 
-  std::vector<Particle> finalState(const Particle& particle, double zInteractionPoint,
-                                   RandomNumberGenerator& rng) const override;
+  // with a library the final state is drawn from the events in the bin of the sampled sqrt(s),
+  // SOPHIA is called directly only outside the library
+  void setEventLibrary(const std::shared_ptr<const SophiaEventLibrary>& library) {
+    m_library = library;
+  }
+  // SOPHIA events are run by nWorkers worker processes, with no workers the calls are serialized
+  void setWorkers(size_t nWorkers) {
+    m_workers = (nWorkers > 0) ? std::make_shared<SophiaWorkerPool>(nWorkers) : nullptr;
+  }
+  static std::shared_ptr<SophiaEventLibrary> generateEventLibrary(size_t nBins = 256,
+                                                                  size_t eventsPerBin = 500);
+  // throws when the file was generated with other parameters or SOPHIA settings
+  static std::shared_ptr<SophiaEventLibrary> loadEventLibrary(const std::string& filename,
+                                                              size_t nBins = 256,
+                                                              size_t eventsPerBin = 500);
+
+  using PhotoPionProduction::finalState;
+  void finalState(const Particle& particle, double zInteractionPoint, RandomNumberGenerator& rng,
+                  std::vector<Particle>& secondaries) const override;
 };
 
 }  // namespace interactions
@@ -0,0 +1,77 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_INTERACTIONS_SOPHIAEVENTLIBRARY_H
+#define SIMPROP_INTERACTIONS_SOPHIAEVENTLIBRARY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "simprop/core/common.h"
+
+namespace simprop {
+namespace interactions {
+
+// Pre-generated photo-pion events binned in (nucleon, sqrt(s)) on a log axis. Each secondary is
+// stored as its fraction of the energy of the incoming nucleon and photon, which does not depend
+// on the frame for ultra-relativistic nucleons, so an event is rescaled to any energy at the
+// same s.
+class SophiaEventLibrary {
+ public:
+  using Secondary = std::pair<PID, double>;
+
+  // the generator string records the settings the events were produced with
+  SophiaEventLibrary(Range sqrtsRange, size_t nBins, size_t eventsPerBin,
+                     const std::string& generator = "");
+  virtual ~SophiaEventLibrary() = default;
+
+  bool isInside(double sqrts) const;
+  size_t findBin(double sqrts) const;
+  double getBinUpperEdge(size_t iBin) const;
+  size_t getBinsSize() const { return m_nBins; }
+  size_t getEventsPerBin() const { return m_eventsPerBin; }
+  const std::string& getGenerator() const { return m_generator; }
+  // true when the library was built with these parameters, e.g. to validate a loaded file
+  bool hasParameters(Range sqrtsRange, size_t nBins, size_t eventsPerBin,
+                     const std::string& generator) const;
+  size_t getEventsSize(PID nucleon, size_t iBin) const;
+  bool isFull(PID nucleon, size_t iBin) const;
+
+  // returns false when the bin is already full or sqrt(s) is outside the library
+  bool add(PID nucleon, double sqrts, const std::vector<Secondary>& secondaries);
+
+  // appends the secondaries of a random event in the bin of sqrt(s), returns false when no
+  // event is available
+  bool sample(double r, PID nucleon, double sqrts, double totalEnergy, double z, double weight,
+              std::vector<Particle>& particles) const;
+
+  void save(const std::string& filename) const;
+  static SophiaEventLibrary load(const std::string& filename);
+
+ protected:
+  // events of one bin, the secondaries of event i are in [offsets[i], offsets[i + 1])
+  struct Bin {
+    std::vector<uint32_t> offsets = {0};
+    std::vector<uint8_t> species;
+    std::vector<float> fractions;
+  };
+
+  uint8_t getSpeciesIndex(PID pid);
+  const Bin& getBin(PID nucleon, size_t iBin) const;
+  Bin& getBin(PID nucleon, size_t iBin);
+
+ protected:
+  double m_lnSqrtsMin;
+  double m_lnSqrtsMax;
+  size_t m_nBins;
+  size_t m_eventsPerBin;
+  std::string m_generator;
+  std::vector<PID> m_species;
+  // proton bins followed by neutron bins
+  std::vector<Bin> m_bins;
+};
+
+}  // namespace interactions
+}  // namespace simprop
+
+#endif  // SIMPROP_INTERACTIONS_SOPHIAEVENTLIBRARY_H
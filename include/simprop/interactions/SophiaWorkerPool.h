@@ -0,0 +1,63 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_INTERACTIONS_SOPHIAWORKERPOOL_H
+#define SIMPROP_INTERACTIONS_SOPHIAWORKERPOOL_H
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct sophiaevent_output;
+
+namespace simprop {
+namespace interactions {
+
+// reseeds the generators SOPHIA draws its uniforms from, the C library rand and drand48, so
+// that the event run right after depends only on the seed and not on the events run before
+void seedSophia(uint64_t seed);
+
+// SOPHIA keeps its state in global common blocks, so one process runs one event at a time. The
+// pool forks worker processes, each with its own copy of that state, and serves the calling
+// threads from a queue of idle workers over pipes. Every request carries the seed its event is
+// run from, so that the event does not depend on the worker serving it. Workers must be started
+// before the threads calling them.
+class SophiaWorkerPool {
+ public:
+  // runs in every worker right after the fork
+  using WorkerInit = std::function<void(size_t iWorker)>;
+
+  SophiaWorkerPool(size_t nWorkers, WorkerInit workerInit = nullptr);
+  SophiaWorkerPool(const SophiaWorkerPool&) = delete;
+  SophiaWorkerPool& operator=(const SophiaWorkerPool&) = delete;
+  virtual ~SophiaWorkerPool();
+
+  size_t getWorkersSize() const { return m_workers.size(); }
+  void event(bool onProton, double Ein, double eps, uint64_t seed, sophiaevent_output& output);
+
+ protected:
+  struct Worker {
+    pid_t pid;
+    int requestFd;
+    int responseFd;
+  };
+
+  static void serve(int requestFd, int responseFd);
+  // runs one event on the given worker, which the caller must own, returns false on failure
+  bool event(size_t iWorker, bool onProton, double Ein, double eps, uint64_t seed,
+             sophiaevent_output& output);
+  void stop();
+
+ protected:
+  std::vector<Worker> m_workers;
+  std::vector<size_t> m_idle;
+  std::mutex m_mutex;
+  std::condition_variable m_idleCondition;
+};
+
+}  // namespace interactions
+}  // namespace simprop
+
+#endif  // SIMPROP_INTERACTIONS_SOPHIAWORKERPOOL_H
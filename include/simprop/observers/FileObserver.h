@@ -0,0 +1,35 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_OBSERVERS_FILEOBSERVER_H
+#define SIMPROP_OBSERVERS_FILEOBSERVER_H
+
+#include <functional>
+#include <string>
+
+#include "simprop/observers/Observer.h"
+#include "simprop/utils/io.h"
+
+namespace simprop {
+namespace observers {
+
+// Writes one line per particle, by default the particle stream format
+class FileObserver : public Observer {
+ public:
+  using Formatter = std::function<std::string(const Particle&)>;
+
+  FileObserver(const std::string& filename);
+  FileObserver(const std::string& filename, Formatter formatter);
+  void observe(const Particle& particle) override;
+  void save(std::ostream& out) override;
+  void load(std::istream& in) override;
+  size_t getCounter() const { return m_counter; }
+
+ protected:
+  utils::OutputFile m_out;
+  Formatter m_formatter;
+  size_t m_counter = 0;
+};
+
+}  // namespace observers
+}  // namespace simprop
+
+#endif
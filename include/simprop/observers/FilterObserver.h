@@ -0,0 +1,43 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_OBSERVERS_FILTEROBSERVER_H
+#define SIMPROP_OBSERVERS_FILTEROBSERVER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "simprop/observers/Observer.h"
+
+namespace simprop {
+namespace observers {
+
+// Forwards to the downstream observers only the particles accepted by the condition
+class FilterObserver : public Observer {
+ public:
+  using Condition = std::function<bool(const Particle&)>;
+
+  FilterObserver(Condition condition, std::vector<std::shared_ptr<Observer>> observers)
+      : m_condition(condition), m_observers(observers) {}
+  void observe(const Particle& particle) override {
+    if (!m_condition(particle)) return;
+    for (const auto& observer : m_observers) observer->observe(particle);
+  }
+  void save(std::ostream& out) override {
+    for (const auto& observer : m_observers) observer->save(out);
+  }
+  void load(std::istream& in) override {
+    for (const auto& observer : m_observers) observer->load(in);
+  }
+
+ protected:
+  Condition m_condition;
+  std::vector<std::shared_ptr<Observer>> m_observers;
+};
+
+// Accepts the particles belonging to one of the given species
+FilterObserver::Condition IsSpecies(const std::vector<PID>& species);
+
+}  // namespace observers
+}  // namespace simprop
+
+#endif
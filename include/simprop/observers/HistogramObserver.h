@@ -0,0 +1,40 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_OBSERVERS_HISTOGRAMOBSERVER_H
+#define SIMPROP_OBSERVERS_HISTOGRAMOBSERVER_H
+
+#include <string>
+#include <vector>
+
+#include "simprop/core/common.h"
+#include "simprop/observers/Observer.h"
+
+namespace simprop {
+namespace observers {
+
+// Accumulates the particle weights in logarithmic energy bins
+class HistogramObserver : public Observer {
+ public:
+  HistogramObserver(Range energyRange, size_t nBins);
+  void observe(const Particle& particle) override;
+  void save(std::ostream& out) override;
+  void load(std::istream& in) override;
+  void dump(const std::string& filename) const;
+
+  const std::vector<double>& getEnergyAxis() const { return m_energyAxis; }
+  const std::vector<double>& getCounts() const { return m_counts; }
+  double getUnderflow() const { return m_underflow; }
+  double getOverflow() const { return m_overflow; }
+
+ protected:
+  double m_lnEnergyMin;
+  double m_dlnEnergy;
+  std::vector<double> m_energyAxis;
+  std::vector<double> m_counts;
+  double m_underflow = 0;
+  double m_overflow = 0;
+};
+
+}  // namespace observers
+}  // namespace simprop
+
+#endif
@@ -0,0 +1,27 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#ifndef SIMPROP_OBSERVERS_OBSERVER_H
+#define SIMPROP_OBSERVERS_OBSERVER_H
+
+#include <istream>
+#include <ostream>
+
+#include "simprop/core/particle.h"
+
+namespace simprop {
+namespace observers {
+
+// A sink receiving every particle that the evolutor retires
+class Observer {
+ public:
+  Observer() {}
+  virtual ~Observer() = default;
+  virtual void observe(const Particle& particle) = 0;
+  // state stored in the evolutor checkpoints
+  virtual void save(std::ostream& out) {}
+  virtual void load(std::istream& in) {}
+};
+
+}  // namespace observers
+}  // namespace simprop
+
+#endif
@@ -3,6 +3,7 @@
 #define SIMPROP_PHOTONFIELDS_CMBPHOTONFIELD_H_
 
 #include <utility>
+#include <vector>
 
 #include "simprop/core/units.h"
 #include "simprop/photonFields/PhotonField.h"
@@ -19,6 +20,11 @@ class CMB final : public PhotonField {
 
   double density(double epsRestFrame, double z = 0.) const override;
   double I_gamma(double epsRestFrame, double z = 0.) const override;
+  void batchDensity(const std::vector<double>& epsRestFrame, double z,
+                    std::vector<double>& values) const override;
+  void batchIgamma(const std::vector<double>& epsRestFrame, double z,
+                   std::vector<double>& values) const override;
+  bool isSelfSimilar() const override { return true; }
 
   double getMinPhotonEnergy() const override { return m_epsRange.first; }
   double getMaxPhotonEnergy() const override { return m_epsRange.second; }
@@ -3,6 +3,7 @@
 #define SIMPROP_PHOTONFIELDS_LOOKUPTABLEPHOTONFIELD_H_
 
 #include <cmath>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,10 +16,14 @@ class LookupTablePhotonField : public PhotonField {
  protected:
   size_t m_zSize, m_eSize;
   std::string m_filename;
-  std::vector<double> m_redshifts;
-  std::vector<double> m_logPhotonEnergies;
-  std::vector<double> m_logDensity;
-  std::vector<double> m_logIgamma;
+  // tables shared by all the fields read from the same file
+  struct Table {
+    std::vector<double> redshifts;
+    std::vector<double> logPhotonEnergies;
+    std::vector<double> logDensity;
+    std::vector<double> logIgamma;
+  };
+  std::shared_ptr<const Table> m_table;
 
  public:
   LookupTablePhotonField(size_t zSize, size_t eSize, std::string filename);
@@ -26,11 +31,15 @@ class LookupTablePhotonField : public PhotonField {
   double density(double epsRestFrame, double z = 0.) const override;
   double I_gamma(double epsRestFrame, double z = 0.) const override;
 
-  double getMinPhotonEnergy() const override { return std::pow(10., m_logPhotonEnergies.front()); }
-  double getMaxPhotonEnergy() const override { return std::pow(10., m_logPhotonEnergies.back()); }
+  double getMinPhotonEnergy() const override {
+    return std::pow(10., m_table->logPhotonEnergies.front());
+  }
+  double getMaxPhotonEnergy() const override {
+    return std::pow(10., m_table->logPhotonEnergies.back());
+  }
 
  protected:
-  void loadDataFile();
+  std::shared_ptr<const Table> loadDataFile() const;
 };
 
 }  // namespace photonfields
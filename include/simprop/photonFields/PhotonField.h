@@ -15,15 +15,27 @@ class PhotonField {
 
   virtual double density(double epsRestFrame, double z = 0.) const = 0;
   virtual double I_gamma(double epsRestFrame, double z = 0.) const = 0;
+  // batch versions filling values[i] at epsRestFrame[i], used by the integrators
+  virtual void batchDensity(const std::vector<double>& epsRestFrame, double z,
+                            std::vector<double>& values) const;
+  virtual void batchIgamma(const std::vector<double>& epsRestFrame, double z,
+                           std::vector<double>& values) const;
 
   double computeIntegratedDensity(double z = 0.) const;
 
+  // true if density(eps, z) = (1+z)^2 density(eps / (1+z), 0), as for a blackbody, so that the
+  // rates and losses on it scale as f(Gamma, z) = (1+z)^3 f(Gamma (1+z), 0)
+  virtual bool isSelfSimilar() const { return false; }
+
   virtual double getMinPhotonEnergy() const = 0;
   virtual double getMaxPhotonEnergy() const = 0;
 };
 
 using PhotonFields = std::vector<std::shared_ptr<photonfields::PhotonField>>;
 
+// true if every field is self-similar, so that the rates and losses summed over them are too
+bool allSelfSimilar(const PhotonFields& photonFields);
+
 }  // namespace photonfields
 }  // namespace simprop
 
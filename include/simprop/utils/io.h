@@ -2,6 +2,7 @@
 #define SIMPROP_UTILS_IO_H
 
 #include <fstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -18,18 +19,45 @@ std::vector<std::string> split(std::string s, std::string delimiter = " ");
 std::vector<double> loadRow(std::string filePath, size_t iRow, std::string delimiter = " ");
 std::vector<std::vector<double> > loadFileByRow(std::string filePath, std::string delimiter = " ");
 
-// Output file
+// Binary streams
+template <typename T>
+void writeBinary(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readBinary(std::istream& in) {
+  T value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  if (!in) throw std::runtime_error("unexpected end of binary stream");
+  return value;
+}
+
+void writeBinaryString(std::ostream& out, const std::string& value);
+std::string readBinaryString(std::istream& in);
+
+// Output file, opened at the first write so that a resumed run can keep its content
 class OutputFile {
   std::string filename;
   std::ofstream out;
 
+  std::ofstream& stream() {
+    if (!out.is_open()) out.open("output/" + filename);
+    return out;
+  }
+
  public:
   OutputFile(const std::string& name);
   ~OutputFile();
 
+  // flushes and returns the number of bytes written so far
+  size_t sync();
+  // keeps the first size bytes of the file and drops the rest, used when resuming a run
+  void truncate(size_t size);
+
   template <typename T>
   OutputFile& operator<<(const T& value) {
-    out << value;
+    stream() << value;
     return *this;
   }
 };
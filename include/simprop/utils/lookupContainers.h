@@ -1,6 +1,7 @@
 #ifndef SIMPROP_UTILS_LOOKUPTABLE_H
 #define SIMPROP_UTILS_LOOKUPTABLE_H
 
+#include <algorithm>
 #include <vector>
 
 #include "simprop/core/units.h"
@@ -26,16 +27,24 @@ class LookupArray {
   inline double get(double x) const { return utils::interpolate(x, m_xAxis, m_array); }
   inline double spline(double x) const { return utils::cspline(x, m_xAxis, m_array); }
   inline bool xIsInside(double x) const { return x >= m_xAxis.front() && x <= m_xAxis.back(); }
+  const std::vector<double>& xAxis() const { return m_xAxis; }
+  const std::vector<double>& data() const { return m_array; }
 
  public:
   void loadTable(const std::string& filePath, size_t iCol = 1) {
     if (!utils::fileExists(filePath))
       throw std::runtime_error("file data for lookup array does not exist");
-    auto v = utils::loadFileByRow(filePath, ",");
+    loadTable(utils::loadFileByRow(filePath, ","), iCol);
+  }
+
+  // from rows already parsed, so that several columns of a file are read with a single parsing
+  void loadTable(const std::vector<std::vector<double>>& rows, size_t iCol = 1) {
+    m_xAxis.clear();
+    m_array.clear();
     for (size_t i = 0; i < xSize; ++i) {
-      auto line = v.at(i);
+      const auto& line = rows.at(i);
       m_xAxis.emplace_back(line[0]);
-      m_array.emplace_back(line[iCol]);
+      m_array.emplace_back(line.at(iCol));
     }
     assert(m_xAxis.size() == xSize && m_array.size() == xSize);
   }
@@ -58,6 +67,22 @@ class LookupArray {
     assert(m_xAxis.size() == xSize && m_array.size() == xSize);
   }
 
+  // fills this array and other on the same axis from a function returning both values
+  void cacheTables(const std::function<std::pair<double, double>(double)>& func,
+                   LookupArray& other, const std::pair<double, double>& range) {
+    std::vector<double> otherArray;
+    otherArray.reserve(xSize);
+    cacheTable(
+        [&func, &otherArray](double x) {
+          const auto values = func(x);
+          otherArray.push_back(values.second);
+          return values.first;
+        },
+        range);
+    other.m_xAxis = m_xAxis;
+    other.m_array.swap(otherArray);
+  }
+
  protected:
   std::vector<double> m_xAxis;
   std::vector<double> m_array;
@@ -124,12 +149,104 @@ class LookupTable {
     assert(m_table.size() == xSize * ySize);
   }
 
+  // fills this table and other on the same axes from a function returning both values
+  void cacheTables(const std::function<std::pair<double, double>(double, double)>& func,
+                   LookupTable& other, const std::pair<double, double>& xRange,
+                   const std::pair<double, double>& yRange) {
+    std::vector<double> otherTable;
+    otherTable.reserve(xSize * ySize);
+    cacheTable(
+        [&func, &otherTable](double x, double y) {
+          const auto values = func(x, y);
+          otherTable.push_back(values.second);
+          return values.first;
+        },
+        xRange, yRange);
+    other.m_xAxis = m_xAxis;
+    other.m_yAxis = m_yAxis;
+    other.m_table.swap(otherTable);
+  }
+
  protected:
   std::vector<double> m_xAxis;
   std::vector<double> m_yAxis;
   std::vector<double> m_table;
 };
 
+// Table on equidistant axes whose innermost rows are computed at once, e.g. inverse CDFs
+template <size_t xSize, size_t ySize, size_t wSize>
+class LookupTable3D {
+ public:
+  LookupTable3D() {
+    if (xSize < 2) throw std::runtime_error("x-axis size must be > 1");
+    if (ySize < 2) throw std::runtime_error("y-axis size must be > 1");
+    if (wSize < 2) throw std::runtime_error("w-axis size must be > 1");
+  }
+
+  // trilinear interpolation, the arguments are clamped to the table ranges
+  inline double get(double x, double y, double w) const {
+    const auto fx = clamp((x - m_xRange.first) / m_dx, xSize);
+    const auto fy = clamp((y - m_yRange.first) / m_dy, ySize);
+    const auto fw = clamp((w - m_wRange.first) / m_dw, wSize);
+    const auto i = (size_t)fx, j = (size_t)fy, k = (size_t)fw;
+    const auto tx = fx - (double)i, ty = fy - (double)j, tw = fw - (double)k;
+    auto row = [&](size_t ii, size_t jj) {
+      const auto offset = (ii * ySize + jj) * wSize + k;
+      return (1. - tw) * m_table[offset] + tw * m_table[offset + 1];
+    };
+    return (1. - tx) * ((1. - ty) * row(i, j) + ty * row(i, j + 1)) +
+           tx * ((1. - ty) * row(i + 1, j) + ty * row(i + 1, j + 1));
+  }
+
+  bool xIsInside(double x) const { return x >= m_xRange.first && x <= m_xRange.second; }
+  bool yIsInside(double y) const { return y >= m_yRange.first && y <= m_yRange.second; }
+  bool isCached() const { return !m_table.empty(); }
+
+ public:
+  void cacheTable(const std::function<std::vector<double>(double, double)>& rowFunc,
+                  const std::pair<double, double>& xRange, const std::pair<double, double>& yRange,
+                  const std::pair<double, double>& wRange) {
+    m_xRange = xRange;
+    m_yRange = yRange;
+    m_wRange = wRange;
+    m_dx = (xRange.second - xRange.first) / (double)(xSize - 1);
+    m_dy = (yRange.second - yRange.first) / (double)(ySize - 1);
+    m_dw = (wRange.second - wRange.first) / (double)(wSize - 1);
+    m_table.clear();
+    m_table.reserve(xSize * ySize * wSize);
+    // Progressbar init
+    auto progressbar = std::make_shared<ProgressBar>(xSize * ySize);
+    auto progressbar_mutex = std::make_shared<std::mutex>();
+    progressbar->setMutex(progressbar_mutex);
+    progressbar->start("Start caching 3D table");
+    for (size_t i = 0; i < xSize; ++i) {
+      auto x = (double)i * m_dx + xRange.first;
+      for (size_t j = 0; j < ySize; ++j) {
+        progressbar->update();
+        auto y = (double)j * m_dy + yRange.first;
+        const auto row = rowFunc(x, y);
+        if (row.size() != wSize) throw std::runtime_error("wrong row size in 3D table");
+        m_table.insert(m_table.end(), row.begin(), row.end());
+      }
+    }
+    assert(m_table.size() == xSize * ySize * wSize);
+  }
+
+ protected:
+  static inline double clamp(double f, size_t size) {
+    return std::min(std::max(f, 0.), (double)(size - 1) - 1e-9);
+  }
+
+ protected:
+  std::pair<double, double> m_xRange;
+  std::pair<double, double> m_yRange;
+  std::pair<double, double> m_wRange;
+  double m_dx = 0;
+  double m_dy = 0;
+  double m_dw = 0;
+  std::vector<double> m_table;
+};
+
 }  // namespace utils
 }  // namespace simprop
 
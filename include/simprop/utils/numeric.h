@@ -9,10 +9,13 @@
 #include <gsl/gsl_odeiv2.h>
 #include <gsl/gsl_roots.h>
 
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <utility>
 #include <vector>
 
 namespace simprop {
@@ -152,6 +155,49 @@ T RombergIntegration(std::function<T(T)> f, T start, T stop, int N, double rel_e
   return T(result);
 }
 
+// Romberg integration of K integrands sharing their nodes. f(x, y) fills y[k][i] with the k-th
+// integrand at x[i] and is called once per refinement level with all its new nodes, so that the
+// integrands can be evaluated by batch kernels. The refinement stops when all the diagonal
+// estimates agree with the previous ones to rel_error.
+template <size_t K, typename F>
+std::array<double, K> batchRombergIntegration(const F &f, double start, double stop, int N,
+                                              double rel_error = 1e-4) {
+  assert(N < 30);
+  std::array<std::array<double, 30>, K> R, C;
+  std::array<std::vector<double>, K> y;
+  std::vector<double> x = {start, stop};
+  for (auto &values : y) values.resize(x.size());
+  f(x, y);
+  double h = stop - start;
+  for (size_t k = 0; k < K; ++k) R[k][0] = 0.5 * h * (y[k][0] + y[k][1]);
+  int n = 1;
+  for (; n < N; ++n) {
+    h *= 0.5;
+    const size_t nNodes = (size_t)1 << (n - 1);
+    x.resize(nNodes);
+    for (size_t i = 0; i < nNodes; ++i) x[i] = start + (double)(2 * i + 1) * h;
+    for (auto &values : y) values.resize(nNodes);
+    f(x, y);
+    bool converged = true;
+    for (size_t k = 0; k < K; ++k) {
+      double sum = 0;
+      for (size_t i = 0; i < nNodes; ++i) sum += y[k][i];
+      C[k][0] = 0.5 * R[k][0] + h * sum;
+      double p = 4.;
+      for (int m = 1; m <= n; ++m) {
+        C[k][m] = C[k][m - 1] + (C[k][m - 1] - R[k][m - 1]) / (p - 1.);
+        p *= 4.;
+      }
+      converged = converged && std::fabs(C[k][n] - R[k][n - 1]) <= rel_error * std::fabs(C[k][n]);
+      for (int m = 0; m <= n; ++m) R[k][m] = C[k][m];
+    }
+    if (n > 3 && converged) break;
+  }
+  std::array<double, K> result;
+  for (size_t k = 0; k < K; ++k) result[k] = (n < N) ? R[k][n] : R[k][n - 1];
+  return result;
+}
+
 template <typename T>
 T simpsonIntegration(std::function<T(T)> f, T start, T stop, int N = 100) {
   const T a = start;
@@ -173,6 +219,12 @@ T simpsonIntegration(std::function<T(T)> f, T start, T stop, int N = 100) {
   return h * (XI0 + 2 * XI2 + 4 * XI1) / 3.0;
 }
 
+// iterations spent in rootFinder by the calling thread, read by the evolutor run statistics
+inline uint64_t &rootFinderIterations() {
+  static thread_local uint64_t counter = 0;
+  return counter;
+}
+
 template <typename T>
 T rootFinder(std::function<T(T)> f, T xLower, T xUpper, int maxIter, double relError = 1e-4) {
   int status;
@@ -203,6 +255,7 @@ T rootFinder(std::function<T(T)> f, T xLower, T xUpper, int maxIter, double relE
   } while (status == GSL_CONTINUE && iter < maxIter);
 
   gsl_root_fsolver_free(solver);
+  rootFinderIterations() += iter;
 
   return r;
 }
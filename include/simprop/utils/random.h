@@ -1,11 +1,75 @@
 #ifndef SIMPROP_UTILS_RANDOM_H
 #define SIMPROP_UTILS_RANDOM_H
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace simprop {
 namespace utils {
 
+// Counter-based Philox4x32-10 generator (Salmon et al. 2011). The n-th output of a stream is a
+// pure function of (seed, stream, n), so independent streams need no shared state.
+class Philox4x32 {
+ public:
+  typedef uint64_t result_type;
+  typedef std::array<uint32_t, 4> counter_type;
+  typedef std::array<uint32_t, 2> key_type;
+
+  Philox4x32(uint64_t seed, uint64_t stream) : m_seed(seed), m_stream(stream) {}
+
+  result_type operator()() {
+    if (m_index == 2) {
+      const auto out = block({(uint32_t)m_counter, (uint32_t)(m_counter >> 32),
+                              (uint32_t)m_stream, (uint32_t)(m_stream >> 32)},
+                             {(uint32_t)m_seed, (uint32_t)(m_seed >> 32)});
+      m_buffer[0] = ((uint64_t)out[1] << 32) | out[0];
+      m_buffer[1] = ((uint64_t)out[3] << 32) | out[2];
+      m_counter++;
+      m_index = 0;
+    }
+    return m_buffer[m_index++];
+  }
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+
+  // the ten rounds bijection mapping a counter to four random words
+  static counter_type block(counter_type ctr, key_type key) {
+    for (size_t round = 0; round < 10; ++round) {
+      if (round > 0) {
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+      }
+      const uint64_t p0 = (uint64_t)0xD2511F53 * ctr[0];
+      const uint64_t p1 = (uint64_t)0xCD9E8D57 * ctr[2];
+      ctr = {(uint32_t)(p1 >> 32) ^ ctr[1] ^ key[0], (uint32_t)p1,
+             (uint32_t)(p0 >> 32) ^ ctr[3] ^ key[1], (uint32_t)p0};
+    }
+    return ctr;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const Philox4x32& g) {
+    return os << g.m_seed << " " << g.m_stream << " " << g.m_counter << " " << g.m_index << " "
+              << g.m_buffer[0] << " " << g.m_buffer[1];
+  }
+  friend std::istream& operator>>(std::istream& is, Philox4x32& g) {
+    return is >> g.m_seed >> g.m_stream >> g.m_counter >> g.m_index >> g.m_buffer[0] >>
+           g.m_buffer[1];
+  }
+
+ private:
+  uint64_t m_seed;
+  uint64_t m_stream;
+  uint64_t m_counter = 0;
+  size_t m_index = 2;
+  std::array<uint64_t, 2> m_buffer = {0, 0};
+};
+
 template <class FloatType = double,
           class = std::enable_if_t<std::is_floating_point<FloatType>::value> >
 class RNG {
@@ -15,9 +79,16 @@ class RNG {
   typedef std::uniform_real_distribution<FloatType> distribution_type;
 
   explicit RNG(const int64_t seed) { eng = generator_type(seed); }
+  // counter-based generator, the draws depend only on (seed, stream) and their position
+  RNG(const uint64_t seed, const uint64_t stream)
+      : philox(seed, stream), isCounterBased(true) {}
 
   // generate next random value in distribution
-  result_type operator()() { return dist(eng); }
+  result_type operator()() {
+    // the 53 high bits are mapped to [0, 1)
+    if (isCounterBased) return static_cast<result_type>((philox() >> 11) * 1.1102230246251565e-16);
+    return dist(eng);
+  }
   // will always yield 0.0 for this class type
   constexpr result_type min() const { return dist.min(); }
   // will always yield 1.0 for this class type
@@ -26,13 +97,84 @@ class RNG {
   // does not rely on previous call
   void reset_distribution_state() { dist.reset(); }
   // uniform distribution
-  result_type uniform(double vMin, double vMax) { return dist(eng) * (vMax - vMin) + vMin; }
+  result_type uniform(double vMin, double vMax) { return (*this)() * (vMax - vMin) + vMin; }
+  // counter-based engine, swapping it parks a stream and resumes another one without reseeding
+  const Philox4x32& getCounterBased() const { return philox; }
+  void setCounterBased(const Philox4x32& engine) {
+    philox = engine;
+    isCounterBased = true;
+  }
+  // engine state, restoring it replays exactly the same sequence
+  std::string getState() const {
+    std::ostringstream out;
+    if (isCounterBased)
+      out << "philox " << philox;
+    else
+      out << eng;
+    return out.str();
+  }
+  void setState(const std::string& state) {
+    std::istringstream in(state);
+    if (state.compare(0, 6, "philox") == 0) {
+      std::string tag;
+      in >> tag;
+      in >> philox;
+      isCounterBased = true;
+    } else {
+      in >> eng;
+      isCounterBased = false;
+    }
+    dist.reset();
+  }
 
  private:
   generator_type eng;
   distribution_type dist;
+  Philox4x32 philox = Philox4x32(0, 0);
+  bool isCounterBased = false;
 };
 
+// Walker's alias method (Vose's construction): n outcomes with given weights are stored as
+// n acceptance probabilities and n aliases, and one uniform number picks an outcome in O(1); the
+// aliases are bytes, so at most 256 outcomes
+template <typename T>
+void buildAliasTable(const T* weights, size_t n, float* probability, uint8_t* alias) {
+  if (n > 256) throw std::invalid_argument("alias tables hold at most 256 outcomes");
+  T sum = 0;
+  for (size_t i = 0; i < n; ++i) sum += weights[i];
+  std::vector<double> scaled(n);
+  std::vector<size_t> small, large;
+  for (size_t i = 0; i < n; ++i) {
+    // outcomes without weight are never picked, all of them only if the weights vanish
+    scaled[i] = (sum > 0) ? (double)weights[i] * (double)n / (double)sum : 1.;
+    probability[i] = 1.f;
+    alias[i] = (uint8_t)i;
+    if (scaled[i] < 1.)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    const auto s = small.back();
+    const auto l = large.back();
+    small.pop_back();
+    probability[s] = (float)scaled[s];
+    alias[s] = (uint8_t)l;
+    scaled[l] -= 1. - scaled[s];
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+}
+
+inline size_t sampleAliasTable(double r, const float* probability, const uint8_t* alias,
+                               size_t n) {
+  const auto x = r * (double)n;
+  const auto i = std::min((size_t)x, n - 1);
+  return (x - (double)i < (double)probability[i]) ? i : alias[i];
+}
+
 }  // namespace utils
 
 using RandomNumberGenerator = simprop::utils::RNG<double>;
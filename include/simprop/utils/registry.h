@@ -0,0 +1,48 @@
+#ifndef SIMPROP_UTILS_REGISTRY_H
+#define SIMPROP_UTILS_REGISTRY_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <utility>
+
+namespace simprop {
+namespace utils {
+
+// Process-wide store of immutable physics data (cross sections, photon field tables, ...).
+// Each dataset is loaded on first request and then shared by all the objects asking for it.
+class DataRegistry {
+ public:
+  template <typename T>
+  static std::shared_ptr<const T> get(const std::string& key,
+                                      const std::function<std::shared_ptr<const T>()>& load) {
+    // recursive, as a dataset may request other datasets while loading
+    std::lock_guard<std::recursive_mutex> lock(mutex());
+    auto& entry = entries()[{std::type_index(typeid(T)), key}];
+    if (!entry) entry = load();
+    return std::static_pointer_cast<const T>(entry);
+  }
+
+  // datasets built by their default constructor
+  template <typename T>
+  static std::shared_ptr<const T> get(const std::string& key = "") {
+    return get<T>(key, [] { return std::shared_ptr<const T>(std::make_shared<T>()); });
+  }
+
+  static size_t size();
+  // drops the references held by the registry, handles already given out stay valid
+  static void clear();
+
+ protected:
+  using Key = std::pair<std::type_index, std::string>;
+  static std::recursive_mutex& mutex();
+  static std::map<Key, std::shared_ptr<const void>>& entries();
+};
+
+}  // namespace utils
+}  // namespace simprop
+
+#endif  // SIMPROP_UTILS_REGISTRY_H
@@ -1,5 +1,6 @@
 #include "simprop/crossSections/BreitWheeler.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "simprop/core/units.h"
@@ -18,6 +19,23 @@ double sigmaInCoMFrame(const double &s) {
          (2. * beta * (pow2(beta) - 2.) + (3. - pow4(beta)) * log((1. + beta) / (1. - beta)));
 }
 
+void sigmaInCoMFrame(const std::vector<double> &s, std::vector<double> &values) {
+  const auto n = s.size();
+  values.resize(n);
+  const double *x = s.data();
+  double *v = values.data();
+  // evaluated with chi clamped to the physical range and masked, so that the loop has no branches
+  for (size_t i = 0; i < n; ++i) {
+    const auto chi = x[i] / 4. / pow2(SI::electronMassC2);
+    const auto beta = std::sqrt(1. - 1. / std::max(chi, 1.));
+    const auto beta2 = beta * beta;
+    const auto value = 3. / 16. * SI::sigmaTh * (1. - beta2) *
+                       (2. * beta * (beta2 - 2.) +
+                        (3. - beta2 * beta2) * std::log((1. + beta) / (1. - beta)));
+    v[i] = (chi < 1. || chi > 1e5) ? 0. : value;
+  }
+}
+
 double sigma(const double &eGamma, const double &eBkg, const double &mu) {
   using std::log;
   using std::sqrt;
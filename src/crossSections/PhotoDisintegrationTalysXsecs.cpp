@@ -1,6 +1,8 @@
 // Copyright 2023 SimProp-dev [MIT License]
 #include "simprop/crossSections/PhotoDisintegrationTalysXsecs.h"
 
+#include <algorithm>
+
 #include "simprop/core/units.h"
 #include "simprop/utils/io.h"
 #include "simprop/utils/logging.h"
@@ -44,6 +46,12 @@ double TalysChannel::get(PID pid, double eps) const {
   return value;
 }
 
+std::vector<PID> TalysChannel::getPids() const {
+  std::vector<PID> pids;
+  for (const auto& it : m_xmap) pids.push_back(it.first);
+  return pids;
+}
+
 PhotoDisintegrationTalysXsec::PhotoDisintegrationTalysXsec() {
   LOGD << "calling " << __func__ << " constructor";
   m_xsec_single.loadXsecMaps(m_singleNucleonFilename);
@@ -67,5 +75,19 @@ double PhotoDisintegrationTalysXsec::getAtEpsPrime(PID pid, double eps) const {
   return std::max(value, 0.);
 }
 
+Range PhotoDisintegrationTalysXsec::getEpsPrimeRange() const {
+  const auto single = m_xsec_single.getEnergyRange();
+  const auto alpha = m_xsec_alpha.getEnergyRange();
+  return {std::min(single.first, alpha.first), std::max(single.second, alpha.second)};
+}
+
+std::vector<PID> PhotoDisintegrationTalysXsec::getPids() const {
+  auto pids = m_xsec_single.getPids();
+  for (const auto& pid : m_xsec_alpha.getPids())
+    if (std::find(pids.begin(), pids.end(), pid) == pids.end()) pids.push_back(pid);
+  std::sort(pids.begin(), pids.end(), [](const PID& a, const PID& b) { return a.get() < b.get(); });
+  return pids;
+}
+
 }  // namespace xsecs
 }  // namespace simprop
@@ -1,5 +1,8 @@
 #include "simprop/crossSections/PhotoPionXsecs.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "simprop/core/units.h"
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
@@ -14,15 +17,43 @@ PhotoPionXsec::PhotoPionXsec() {
   {
     auto filename = "data/xsecs_photopion_proton_sophia.txt";
     if (!utils::fileExists(filename)) throw std::runtime_error("data file not found");
-    m_proton_sigma.loadTable(filename, 1);
-    m_proton_phi.loadTable(filename, 2);
+    const auto rows = utils::loadFileByRow(filename, ",");
+    m_proton_sigma.loadTable(rows, 1);
+    m_proton_phi.loadTable(rows, 2);
   }
   {
     auto filename = "data/xsecs_photopion_neutron_sophia.txt";
     if (!utils::fileExists(filename)) throw std::runtime_error("data file not found");
-    m_neutron_sigma.loadTable(filename, 1);
-    m_neutron_phi.loadTable(filename, 2);
+    const auto rows = utils::loadFileByRow(filename, ",");
+    m_neutron_sigma.loadTable(rows, 1);
+    m_neutron_phi.loadTable(rows, 2);
+  }
+  m_proton_inversePhi = buildInversePhi(m_proton_phi.xAxis(), m_proton_phi.data());
+  m_neutron_inversePhi = buildInversePhi(m_neutron_phi.xAxis(), m_neutron_phi.data());
+}
+
+PhotoPionXsec::InversePhi PhotoPionXsec::buildInversePhi(const std::vector<double>& s,
+                                                         const std::vector<double>& phi) {
+  // phi is tabulated as a non-decreasing function of s, each node of the ln phi grid is
+  // inverted exactly on the piecewise linear interpolation used by getPhiAtS
+  InversePhi inverse;
+  size_t i = 0;
+  while (i + 1 < phi.size() && phi[i + 1] <= 0.) i++;
+  if (i + 2 >= phi.size()) throw std::runtime_error("phi table has no positive values");
+  inverse.sZero = s[i];
+  inverse.phiMin = phi[i + 1];
+  inverse.lnPhiMin = std::log(inverse.phiMin);
+  inverse.dlnPhi = (std::log(phi.back()) - inverse.lnPhiMin) / (double)(m_inversePhiSize - 1);
+  inverse.s.reserve(m_inversePhiSize);
+  for (size_t k = 0; k < m_inversePhiSize; ++k) {
+    const auto lnPhi = inverse.lnPhiMin + (double)k * inverse.dlnPhi;
+    const auto target = std::min(std::exp(lnPhi), phi.back());
+    while (i + 2 < phi.size() && phi[i + 1] < target) i++;
+    const auto dphi = phi[i + 1] - phi[i];
+    const auto t = (dphi > 0.) ? (target - phi[i]) / dphi : 1.;
+    inverse.s.push_back(s[i] + std::min(std::max(t, 0.), 1.) * (s[i + 1] - s[i]));
   }
+  return inverse;
 }
 
 double PhotoPionXsec::getEpsPrimeThreshold() const {
@@ -76,5 +107,21 @@ double PhotoPionXsec::getPhiAtS(PID pid, double s) const {
   return std::max(value, 0.) * pow2(SI::GeV2) * SI::mbarn;
 }
 
+double PhotoPionXsec::getSAtPhi(PID pid, double phi) const {
+  if (!pidIsNucleon(pid)) throw std::runtime_error("phi not implemented for nuclei in the SPM");
+  const auto& inverse = (pid == proton) ? m_proton_inversePhi : m_neutron_inversePhi;
+  const auto phiTable = phi / (pow2(SI::GeV2) * SI::mbarn);
+  double value = inverse.sZero;
+  if (phiTable >= inverse.phiMin) {
+    const auto x = (std::log(phiTable) - inverse.lnPhiMin) / inverse.dlnPhi;
+    const auto i = std::min((size_t)x, m_inversePhiSize - 2);
+    const auto t = std::min(x - (double)i, 1.);
+    value = (1. - t) * inverse.s[i] + t * inverse.s[i + 1];
+  } else if (phiTable > 0.) {
+    value += (inverse.s.front() - inverse.sZero) * phiTable / inverse.phiMin;
+  }
+  return value * SI::GeV2;
+}
+
 }  // namespace xsecs
 }  // namespace simprop
\ No newline at end of file
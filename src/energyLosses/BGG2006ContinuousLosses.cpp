@@ -2,20 +2,26 @@
 
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
+#include "simprop/utils/registry.h"
 
 namespace simprop {
 namespace losses {
 
 BGG2006ContinuousLosses::BGG2006ContinuousLosses() : ContinuousLosses() {
-  m_totalLosses.loadTable(totalLossesFilename);
+  const auto filename = totalLossesFilename;
+  m_totalLosses = utils::DataRegistry::get<utils::LookupArray<501>>(filename, [filename]() {
+    auto table = std::make_shared<utils::LookupArray<501>>();
+    table->loadTable(filename);
+    return std::shared_ptr<const utils::LookupArray<501>>(table);
+  });
   LOGD << "calling " << __func__ << " constructor";
 }
 
 double BGG2006ContinuousLosses::getInterpolated(double E) const {
   double b_l = 0;
   const auto logE = std::log10(E / SI::eV);
-  if (m_totalLosses.xIsInside(logE)) {
-    b_l = std::pow(10., m_totalLosses.get(logE));
+  if (m_totalLosses->xIsInside(logE)) {
+    b_l = std::pow(10., m_totalLosses->get(logE));
     b_l /= SI::year;
   }
   return b_l;
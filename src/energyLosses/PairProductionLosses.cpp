@@ -1,5 +1,6 @@
 #include "simprop/energyLosses/PairProductionLosses.h"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 
@@ -10,26 +11,20 @@
 namespace simprop {
 namespace losses {
 
-double sum_c(double k) {
-  static auto _c = std::array<double, 4>{0.8048, 0.1459, 1.137e-3, -3.879e-6};
-  double value = 0;
-  for (size_t i = 1; i <= 4; ++i) value += _c[i - 1] * std::pow(k - 2, (double)i);
-  return value;
+// polynomial sums of the phi fits in Horner form
+inline double sum_c(double k) {
+  const auto t = k - 2.;
+  return t * (0.8048 + t * (0.1459 + t * (1.137e-3 + t * -3.879e-6)));
 }
 
-double sum_d(double k) {
-  static auto _d = std::array<double, 4>{-86.07, 50.96, -14.45, 8 / 3.};
-  auto lnk = std::log(k);
-  double value = 0;
-  for (size_t i = 0; i <= 3; ++i) value += _d[i] * std::pow(lnk, (double)i);
-  return value;
+inline double sum_d(double k) {
+  const auto lnk = std::log(k);
+  return -86.07 + lnk * (50.96 + lnk * (-14.45 + lnk * (8. / 3.)));
 }
 
-double sum_f(double k) {
-  static auto _f = std::array<double, 3>{2.910, 78.35, 1837};
-  double value = 0;
-  for (size_t i = 1; i <= 3; ++i) value += _f[i - 1] / std::pow(k, (double)i);
-  return value;
+inline double sum_f(double k) {
+  const auto u = 1. / k;
+  return u * (2.910 + u * (78.35 + u * 1837.));
 }
 
 double phi(double k) {
@@ -42,6 +37,20 @@ double phi(double k) {
   }
 }
 
+void phi(const std::vector<double>& k, std::vector<double>& values) {
+  const auto n = k.size();
+  values.resize(n);
+  const double* x = k.data();
+  double* v = values.data();
+  // both fits are evaluated and selected, so that the loop has no branches
+  for (size_t i = 0; i < n; ++i) {
+    const auto low = M_PI / 12. * pow4(x[i] - 2.) / (1. + sum_c(x[i]));
+    const auto high = (x[i] * sum_d(x[i])) / (1. - sum_f(x[i]));
+    const auto value = (x[i] < 25.) ? low : high;
+    v[i] = (x[i] < 2.) ? 0. : value;
+  }
+}
+
 PairProductionLosses::PairProductionLosses(
     const std::shared_ptr<photonfields::PhotonField>& photonField)
     : ContinuousLosses() {
@@ -55,6 +64,14 @@ PairProductionLosses::PairProductionLosses(const photonfields::PhotonFields& pho
 }
 
 void PairProductionLosses::doCaching() {
+  m_isSelfSimilar = photonfields::allSelfSimilar(m_photonFields);
+  if (m_isSelfSimilar) {
+    m_scaledBetaProtons.cacheTable(
+        [this](double lnGamma) { return computeProtonBeta(std::exp(lnGamma), 0.); },
+        {std::log(1e7), std::log(1e14 * (1. + 10.))});
+    m_doCaching = true;
+    return;
+  }
   m_betaProtons.cacheTable(
       [this](double lnGamma, double z) {
         auto Gamma = std::exp(lnGamma);
@@ -73,12 +90,20 @@ double PairProductionLosses::computeProtonBeta(double Gamma, double z,
     const auto epsmax = phField->getMaxPhotonEnergy();
     const auto lkmin = std::log(TwoGamma_mec2 * epsmin);
     const auto lkmax = std::log(TwoGamma_mec2 * epsmax);
-    value += utils::RombergIntegration<double>(
-        [TwoGamma_mec2, phField, z](double lnk) {
-          auto k = std::exp(lnk);
-          return phi(k) / k * phField->density(k / TwoGamma_mec2, z);
+    std::vector<double> k, eps, phis, densities;
+    value += utils::batchRombergIntegration<1>(
+        [&](const std::vector<double>& lnk, std::array<std::vector<double>, 1>& y) {
+          k.resize(lnk.size());
+          eps.resize(lnk.size());
+          for (size_t i = 0; i < lnk.size(); ++i) {
+            k[i] = std::exp(lnk[i]);
+            eps[i] = k[i] / TwoGamma_mec2;
+          }
+          phi(k, phis);
+          phField->batchDensity(eps, z, densities);
+          for (size_t i = 0; i < lnk.size(); ++i) y[0][i] = phis[i] / k[i] * densities[i];
         },
-        lkmin, lkmax, N, 1e-4);
+        lkmin, lkmax, (int)N, 1e-4)[0];
   }
   constexpr auto factor = SI::alpha * pow2(SI::electronRadius) * SI::cLight * SI::electronMassC2 *
                           (SI::electronMass / SI::protonMass);
@@ -88,7 +113,11 @@ double PairProductionLosses::computeProtonBeta(double Gamma, double z,
 }
 
 double PairProductionLosses::beta(PID pid, double Gamma, double z) const {
-  auto b_l = (m_doCaching) ? m_betaProtons.get(std::log(Gamma), z) : computeProtonBeta(Gamma, z);
+  double b_l = 0;
+  if (m_doCaching && m_isSelfSimilar)
+    b_l = pow3(1. + z) * m_scaledBetaProtons.get(std::log(Gamma * (1. + z)));
+  else
+    b_l = (m_doCaching) ? m_betaProtons.get(std::log(Gamma), z) : computeProtonBeta(Gamma, z);
   auto Z = (double)getPidNucleusCharge(pid);
   auto A = (double)getPidNucleusMassNumber(pid);
   b_l *= pow2(Z) / A;
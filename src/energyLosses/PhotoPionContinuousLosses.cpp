@@ -6,50 +6,101 @@
 #include "simprop/photonFields/CmbPhotonField.h"
 #include "simprop/photonFields/Dominguez2011PhotonField.h"
 #include "simprop/utils/logging.h"
+#include "simprop/utils/registry.h"
 #include "simprop/utils/timer.h"
 
 namespace simprop {
 namespace losses {
 
-double inelasticity(double epsPrime) {
-  static const double Y0 = 0.47;
-  static const double b = 6e9 * SI::eV;
-  static const double d = 0.33;
-  static const double s = 0.15;
-  const auto x = epsPrime / b;
-  return Y0 * std::pow(x, d) / std::pow(1. + std::pow(x, d / s), s);
+namespace {
+// Y0 x^d / (1 + x^(d/s))^s written with a single logarithm
+inline double inelasticityKernel(double epsPrime) {
+  constexpr double Y0 = 0.47;
+  constexpr double b = 6e9 * SI::eV;
+  constexpr double d = 0.33;
+  constexpr double s = 0.15;
+  const auto lnx = std::log(epsPrime / b);
+  return Y0 * std::exp(d * lnx - s * std::log1p(std::exp(d / s * lnx)));
+}
+}  // namespace
+
+double inelasticity(double epsPrime) { return inelasticityKernel(epsPrime); }
+
+void inelasticity(const std::vector<double>& epsPrime, std::vector<double>& values) {
+  const auto n = epsPrime.size();
+  values.resize(n);
+  const double* x = epsPrime.data();
+  double* v = values.data();
+  for (size_t i = 0; i < n; ++i) v[i] = inelasticityKernel(x[i]);
 }
 
 PhotoPionContinuousLosses::PhotoPionContinuousLosses(
     const std::shared_ptr<photonfields::PhotonField>& photonField)
-    : ContinuousLosses() {
+    : ContinuousLosses(), m_xs(utils::DataRegistry::get<xsecs::PhotoPionXsec>()) {
   m_photonFields.push_back(photonField);
   LOGD << "calling " << __func__ << " constructor";
 }
 
 PhotoPionContinuousLosses::PhotoPionContinuousLosses(const photonfields::PhotonFields& photonFields)
-    : ContinuousLosses(), m_photonFields(photonFields) {
+    : ContinuousLosses(),
+      m_photonFields(photonFields),
+      m_xs(utils::DataRegistry::get<xsecs::PhotoPionXsec>()) {
+  LOGD << "calling " << __func__ << " constructor";
+}
+
+PhotoPionContinuousLosses::PhotoPionContinuousLosses(
+    const std::shared_ptr<const interactions::PhotoPionProduction>& interaction)
+    : ContinuousLosses(),
+      m_xs(utils::DataRegistry::get<xsecs::PhotoPionXsec>()),
+      m_interaction(interaction) {
+  m_photonFields.push_back(interaction->getPhotonField());
   LOGD << "calling " << __func__ << " constructor";
 }
 
+void PhotoPionContinuousLosses::doCaching() {
+  // the interaction tables are read instead
+  if (m_interaction) return;
+  m_isSelfSimilar = photonfields::allSelfSimilar(m_photonFields);
+  if (m_isSelfSimilar) {
+    const Range lnScaledGammaRange = {std::log(1e7), std::log(1e14 * (1. + 10.))};
+    m_scaledBetaProtons.cacheTable(
+        [this](double lnGamma) { return computeBeta(proton, std::exp(lnGamma), 0.); },
+        lnScaledGammaRange);
+    m_scaledBetaNeutrons.cacheTable(
+        [this](double lnGamma) { return computeBeta(neutron, std::exp(lnGamma), 0.); },
+        lnScaledGammaRange);
+  } else {
+    m_betaProtons.cacheTable(
+        [this](double lnGamma, double z) { return computeBeta(proton, std::exp(lnGamma), z); },
+        {std::log(1e7), std::log(1e14)}, {0., 10.});
+    m_betaNeutrons.cacheTable(
+        [this](double lnGamma, double z) { return computeBeta(neutron, std::exp(lnGamma), z); },
+        {std::log(1e7), std::log(1e14)}, {0., 10.});
+  }
+  m_doCaching = true;
+}
+
 double PhotoPionContinuousLosses::beta(PID pid, double Gamma, double z) const {
-  auto value = 0.;
-  auto epsThr = m_xs.getEpsPrimeThreshold();
-
-  for (auto phField : m_photonFields) {
-    auto lnEpsPrimeMin = std::log(std::max(epsThr, 2. * Gamma * phField->getMinPhotonEnergy()));
-    auto lnEpsPrimeMax = std::log(2. * Gamma * phField->getMaxPhotonEnergy());
-    if (lnEpsPrimeMax > lnEpsPrimeMin) {
-      value += utils::RombergIntegration<double>(
-          [&](double lnEpsPrime) {
-            auto epsPrime = std::exp(lnEpsPrime);
-            return epsPrime * epsPrime * m_xs.getAtEpsPrime(pid, epsPrime) *
-                   inelasticity(epsPrime) * phField->I_gamma(epsPrime / 2. / Gamma, z);
-          },
-          lnEpsPrimeMin, lnEpsPrimeMax, 15, 1e-3);
-    }
+  if (m_interaction) return m_interaction->beta(pid, Gamma, z);
+  if (m_doCaching) {
+    auto Z = getPidNucleusCharge(pid);
+    auto A = getPidNucleusMassNumber(pid);
+    const auto lnScaledGamma = std::log(Gamma * (1. + z));
+    if (m_isSelfSimilar && m_scaledBetaProtons.xIsInside(lnScaledGamma))
+      return pow3(1. + z) * (Z * m_scaledBetaProtons.get(lnScaledGamma) +
+                             (A - Z) * m_scaledBetaNeutrons.get(lnScaledGamma));
+    const auto lnGamma = std::log(Gamma);
+    if (!m_isSelfSimilar && m_betaProtons.xIsInside(lnGamma) && m_betaProtons.yIsInside(z))
+      return Z * m_betaProtons.get(lnGamma, z) + (A - Z) * m_betaNeutrons.get(lnGamma, z);
   }
-  return SI::cLight / 2. / pow2(Gamma) * std::max(value, 0.);
+  return computeBeta(pid, Gamma, z);
+}
+
+double PhotoPionContinuousLosses::computeBeta(PID pid, double Gamma, double z) const {
+  auto value = 0.;
+  for (const auto& phField : m_photonFields)
+    value += interactions::computeRateAndBeta(*m_xs, *phField, pid, Gamma, z).second;
+  return value;
 }
 
 }  // namespace losses
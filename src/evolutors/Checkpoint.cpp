@@ -0,0 +1,94 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "simprop/utils/io.h"
+#include "simprop/utils/logging.h"
+
+namespace simprop {
+namespace evolutors {
+
+namespace {
+
+const uint64_t checkpointMagic = 0x53505043484b3033;  // "SPPCHK03"
+
+void writeStack(std::ostream& out, const ParticleStack& stack) {
+  utils::writeBinary<uint64_t>(out, stack.size());
+  for (const auto& particle : stack) {
+    utils::writeBinary<int64_t>(out, particle.getPid().get());
+    utils::writeBinary(out, particle.getOrigin().z);
+    utils::writeBinary(out, particle.getOrigin().Gamma);
+    utils::writeBinary(out, particle.getRedshift());
+    utils::writeBinary(out, particle.getGamma());
+    utils::writeBinary(out, particle.getWeight());
+    utils::writeBinary<uint8_t>(out, particle.isActive());
+  }
+}
+
+ParticleStack readStack(std::istream& in) {
+  const auto size = utils::readBinary<uint64_t>(in);
+  ParticleStack stack;
+  stack.reserve(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    const auto pid = PID(utils::readBinary<int64_t>(in));
+    const auto zOrigin = utils::readBinary<double>(in);
+    const auto GammaOrigin = utils::readBinary<double>(in);
+    const auto z = utils::readBinary<double>(in);
+    const auto Gamma = utils::readBinary<double>(in);
+    const auto weight = utils::readBinary<double>(in);
+    const auto isActive = utils::readBinary<uint8_t>(in);
+    Particle particle(pid, zOrigin, GammaOrigin, weight);
+    particle.getNow() = {z, Gamma};
+    if (!isActive) particle.deactivate();
+    stack.push_back(particle);
+  }
+  return stack;
+}
+
+}  // namespace
+
+void Checkpoint::save(const std::string& filename) const {
+  // the file is replaced only once the new checkpoint is complete
+  const auto tmpFilename = filename + ".tmp";
+  {
+    std::ofstream out(tmpFilename, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("cannot open checkpoint file " + tmpFilename);
+    utils::writeBinary(out, checkpointMagic);
+    utils::writeBinary<uint64_t>(out, nPrimaries);
+    utils::writeBinary<uint64_t>(out, nextPrimary);
+    utils::writeBinary<uint64_t>(out, seed);
+    writeStack(out, pending);
+    utils::writeBinaryString(out, rngState);
+    utils::writeBinary<uint64_t>(out, observersState.size());
+    for (const auto& state : observersState) utils::writeBinaryString(out, state);
+    if (!out) throw std::runtime_error("failed writing checkpoint file " + tmpFilename);
+  }
+  if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    throw std::runtime_error("cannot move checkpoint to " + filename);
+  LOGD << "checkpoint written at primary " << nextPrimary << " of " << nPrimaries;
+}
+
+Checkpoint Checkpoint::load(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) throw std::runtime_error("cannot open checkpoint file " + filename);
+  if (utils::readBinary<uint64_t>(in) != checkpointMagic)
+    throw std::runtime_error(filename + " is not a checkpoint file");
+  Checkpoint checkpoint;
+  checkpoint.nPrimaries = utils::readBinary<uint64_t>(in);
+  checkpoint.nextPrimary = utils::readBinary<uint64_t>(in);
+  checkpoint.seed = utils::readBinary<uint64_t>(in);
+  checkpoint.pending = readStack(in);
+  checkpoint.rngState = utils::readBinaryString(in);
+  const auto nObservers = utils::readBinary<uint64_t>(in);
+  for (uint64_t i = 0; i < nObservers; ++i)
+    checkpoint.observersState.push_back(utils::readBinaryString(in));
+  LOGD << "checkpoint read at primary " << checkpoint.nextPrimary << " of "
+       << checkpoint.nPrimaries;
+  return checkpoint;
+}
+
+}  // namespace evolutors
+}  // namespace simprop
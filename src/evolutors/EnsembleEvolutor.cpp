@@ -0,0 +1,312 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/EnsembleEvolutor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "simprop/utils/logging.h"
+
+namespace simprop {
+namespace evolutors {
+
+EnsembleEvolutor::EnsembleEvolutor(RandomNumberGenerator& rng) : SingleProtonEvolutor(rng) {
+  LOGD << "calling " << __func__ << " constructor";
+}
+
+void EnsembleEvolutor::dropTables(bool isLosses, bool isRates) {
+  SingleProtonEvolutor::dropTables(isLosses, isRates);
+  // the grids hold both the losses and the rates, the species of the primaries are cached again
+  // at the next run
+  m_species.clear();
+  m_lossesGrid.clear();
+  m_ratesGrid.clear();
+}
+
+size_t EnsembleEvolutor::findSpeciesIndex(PID pid) const {
+  return std::find(m_species.begin(), m_species.end(), pid) - m_species.begin();
+}
+
+void EnsembleEvolutor::doCachingEnsemble(const std::vector<PID>& species) {
+  for (const auto& pid : species) {
+    if (findSpeciesIndex(pid) < m_species.size()) continue;
+    if (m_lossesTables.find(pid) == m_lossesTables.end()) doCachingLosses({pid});
+    const auto& losses = m_lossesTables.at(pid);
+    m_lnGammaSize = losses.getLnGammaSize();
+    m_zSize = losses.getRedshiftSize();
+    m_lnGammaMin = std::log(m_tablesGammaRange.first);
+    m_dlnGamma =
+        (std::log(m_tablesGammaRange.second) - m_lnGammaMin) / (double)(m_lnGammaSize - 1);
+    m_dz = (m_tablesRedshiftRange.second - m_tablesRedshiftRange.first) / (double)(m_zSize - 1);
+
+    LOGD << "caching ensemble rates table for " << getPidName(pid);
+    m_lossesGrid.insert(m_lossesGrid.end(), losses.data().begin(), losses.data().end());
+    for (size_t i = 0; i < m_lnGammaSize; ++i) {
+      const auto Gamma = std::exp(m_lnGammaMin + (double)i * m_dlnGamma);
+      for (size_t j = 0; j < m_zSize; ++j) {
+        const auto z = m_tablesRedshiftRange.first + (double)j * m_dz;
+        m_ratesGrid.push_back(totalRate(pid, Gamma, z));
+      }
+    }
+    m_species.push_back(pid);
+  }
+}
+
+void EnsembleEvolutor::push(const Particle& particle, size_t iPrimary, ParticleStack& finished) {
+  if (!IsActive(particle)) {
+    finished.push_back(particle);
+    return;
+  }
+  const auto iSpecies = findSpeciesIndex(particle.getPid());
+  const auto lnGamma = std::log(particle.getGamma());
+  const auto z = particle.getRedshift();
+  if (iSpecies == m_species.size() || lnGamma >= std::log(m_tablesGammaRange.second) ||
+      z >= m_tablesRedshiftRange.second) {
+    m_scalar.push_back(particle);
+    m_scalarPrimary.push_back(iPrimary);
+    return;
+  }
+  m_speciesIndex.push_back(iSpecies);
+  m_primary.push_back(iPrimary);
+  m_z.push_back(z);
+  m_Gamma.push_back(particle.getGamma());
+  m_weight.push_back(particle.getWeight());
+  m_zOrigin.push_back(particle.getOrigin().z);
+  m_GammaOrigin.push_back(particle.getOrigin().Gamma);
+  m_alive.push_back(1);
+}
+
+Particle EnsembleEvolutor::pull(size_t i) const {
+  Particle particle(m_species[m_speciesIndex[i]], m_zOrigin[i], m_GammaOrigin[i], m_weight[i]);
+  particle.getNow() = {m_z[i], m_Gamma[i]};
+  return particle;
+}
+
+double EnsembleEvolutor::invertLosses(size_t offset, double t, double value) const {
+  // same inversion as LossesCharacteristicTable::findRedshift on the flattened grid
+  auto row = [&](size_t j) {
+    return (1. - t) * m_lossesGrid[offset + j] + t * m_lossesGrid[offset + m_zSize + j];
+  };
+  if (value <= row(0)) return m_tablesRedshiftRange.first;
+  size_t lo = 0, hi = m_zSize - 1;
+  while (hi - lo > 1) {
+    const auto mid = (lo + hi) / 2;
+    if (row(mid) < value)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  const auto rLow = row(lo);
+  const auto rHigh = row(hi);
+  const auto s = (rHigh > rLow) ? (value - rLow) / (rHigh - rLow) : 0.;
+  return m_tablesRedshiftRange.first + ((double)lo + s) * m_dz;
+}
+
+void EnsembleEvolutor::stepBlock(size_t begin, size_t end, ParticleStack& finished,
+                                 ThreadStats* stats) {
+  const auto n = end - begin;
+  if (stats) stats->steps.add(n);
+
+  // table lookups, written as plain loops over the block arrays
+  const auto cosmology = m_cosmology.get();
+  const auto zMin = m_tablesRedshiftRange.first;
+  const auto stride = m_lnGammaSize * m_zSize;
+  const auto maxRow = (double)(m_lnGammaSize - 2);
+  const auto maxColumn = (double)(m_zSize - 2);
+  const double* z = m_z.data() + begin;
+  const double* Gamma = m_Gamma.data() + begin;
+  const size_t* species = m_speciesIndex.data() + begin;
+  for (size_t k = 0; k < n; ++k) {
+    const auto x = std::min(std::max((std::log(Gamma[k]) - m_lnGammaMin) / m_dlnGamma, 0.), maxRow);
+    const auto y = std::min(std::max((z[k] - zMin) / m_dz, 0.), maxColumn);
+    const auto i = (size_t)x;
+    const auto j = (size_t)y;
+    const auto t = x - (double)i;
+    const auto s = y - (double)j;
+    const auto offset = species[k] * stride + i * m_zSize;
+    const auto w00 = (1. - t) * (1. - s), w01 = (1. - t) * s, w10 = t * (1. - s), w11 = t * s;
+    const auto node = offset + j;
+    m_lossesNow[k] = w00 * m_lossesGrid[node] + w01 * m_lossesGrid[node + 1] +
+                     w10 * m_lossesGrid[node + m_zSize] + w11 * m_lossesGrid[node + m_zSize + 1];
+    const auto rate = w00 * m_ratesGrid[node] + w01 * m_ratesGrid[node + 1] +
+                      w10 * m_ratesGrid[node + m_zSize] + w11 * m_ratesGrid[node + m_zSize + 1];
+    m_rateDtdz[k] = std::fabs(rate) * cosmology->dtdz(z[k]);
+    m_rowOffset[k] = offset;
+    m_tGamma[k] = t;
+  }
+
+  // the redshift at which the losses reach deltaGammaCritical
+  const auto lnCritical = std::log(1. - deltaGammaCritical);
+  for (size_t k = 0; k < n; ++k) {
+    const auto value = m_lossesNow[k] + lnCritical;
+    m_zNext[k] = (value > 0.) ? invertLosses(m_rowOffset[k], m_tGamma[k], value) : zMin;
+  }
+
+  // the random numbers are drawn here, in array order, so that the draws of a primary do not
+  // depend on the block size
+  for (size_t k = 0; k < n; ++k) {
+    const auto iParticle = begin + k;
+    const auto iPrimary = m_primary[iParticle];
+    const auto iSpecies = m_speciesIndex[iParticle];
+    const auto zNow = m_z[iParticle];
+    const auto dz_c = zNow - m_zNext[k];
+    m_streamRng.setCounterBased(m_streams[iPrimary]);
+    double dz_s = 0;
+    const auto opacity = m_speciesOpacities[iSpecies];
+    const auto majorant = opacity ? nullptr : m_speciesMajorants[iSpecies];
+    if (opacity) {
+      dz_s = opacity->sampleRedshiftInterval(m_Gamma[iParticle], zNow, m_streamRng());
+      if (dz_s <= dz_c && dz_s <= zNow) {
+        if (stats) stats->rateEvaluations.add();
+        computeRates(pull(iParticle), zNow - dz_s, m_cumulativeRates);
+      }
+    } else if (majorant) {
+      dz_s = sampleNullCollisions(*majorant, pull(iParticle), dz_c, m_cumulativeRates,
+                                  m_streamRng, stats);
+    } else {
+      // a zero rate would divide to an infinity, which -ffast-math does not handle
+      const auto r = m_streamRng();
+      dz_s = (m_rateDtdz[k] > 0.) ? -std::log(1. - r) / m_rateDtdz[k]
+                                  : std::numeric_limits<double>::max();
+      if (dz_s <= dz_c && dz_s <= zNow) {
+        if (stats) stats->rateEvaluations.add();
+        computeRates(pull(iParticle), m_cumulativeRates);
+      }
+    }
+    if (dz_s > dz_c || dz_s > zNow) {
+      m_z[iParticle] = m_zNext[k];
+      m_Gamma[iParticle] *= std::exp(std::max(-m_lossesNow[k], lnCritical));
+      if (m_z[iParticle] <= minPropagatingRedshift || m_Gamma[iParticle] <= minPropagatingGamma) {
+        finished.push_back(pull(iParticle));
+        m_alive[iParticle] = 0;
+      }
+    } else {
+      // interacting particles leave the ensemble through the scalar path
+      auto particle = pull(iParticle);
+      particle.deactivate();
+      m_alive[iParticle] = 0;
+      const auto channel = sampleInteraction(m_cumulativeRates, m_streamRng);
+      PhaseTimer finalStateTimer(stats, ThreadStats::finalState);
+      m_finalState.clear();
+      m_interactions[channel]->finalState(particle, zNow - dz_s, m_streamRng, m_finalState);
+      if (m_weightWindow) m_weightWindow->apply(m_finalState, m_streamRng);
+      finalStateTimer.stop();
+      if (stats) {
+        stats->interactionsPerChannel[channel].add();
+        stats->secondaries.add(m_finalState.size());
+      }
+      finished.push_back(particle);
+      for (const auto& secondary : m_finalState) push(secondary, iPrimary, finished);
+    }
+    m_streams[iPrimary] = m_streamRng.getCounterBased();
+  }
+}
+
+void EnsembleEvolutor::compact() {
+  size_t last = 0;
+  for (size_t i = 0; i < m_alive.size(); ++i) {
+    if (!m_alive[i]) continue;
+    m_z[last] = m_z[i];
+    m_Gamma[last] = m_Gamma[i];
+    m_weight[last] = m_weight[i];
+    m_speciesIndex[last] = m_speciesIndex[i];
+    m_primary[last] = m_primary[i];
+    m_zOrigin[last] = m_zOrigin[i];
+    m_GammaOrigin[last] = m_GammaOrigin[i];
+    m_alive[last] = 1;
+    last++;
+  }
+  m_z.resize(last);
+  m_Gamma.resize(last);
+  m_weight.resize(last);
+  m_speciesIndex.resize(last);
+  m_primary.resize(last);
+  m_zOrigin.resize(last);
+  m_GammaOrigin.resize(last);
+  m_alive.resize(last);
+}
+
+void EnsembleEvolutor::run(ParticleStack& stack) {
+  if (!m_cosmology) throw std::runtime_error("cosmology must be added before running");
+  if (!m_checkpointFilename.empty()) {
+    LOGW << "checkpoints are not written by the ensemble evolutor";
+  }
+  if (!m_hasSeed) m_seed = static_cast<uint64_t>(m_rng() * 9007199254740992.);
+  LOGI << "evolving ensemble of " << stack.size() << " primaries with seed " << m_seed;
+
+  // the tables are built before evolving, species appearing later take the scalar path
+  for (const auto& particle : stack)
+    if (IsActive(particle)) doCachingEnsemble({particle.getPid()});
+  m_speciesOpacities.assign(m_species.size(), nullptr);
+  m_speciesMajorants.assign(m_species.size(), nullptr);
+  for (size_t i = 0; i < m_species.size(); ++i) {
+    const auto opacity = m_opacityTables.find(m_species[i]);
+    if (opacity != m_opacityTables.end()) m_speciesOpacities[i] = &opacity->second;
+    const auto majorant = m_rateMajorants.find(m_species[i]);
+    if (majorant != m_rateMajorants.end()) m_speciesMajorants[i] = &majorant->second;
+  }
+
+  m_rateDtdz.resize(m_blockSize);
+  m_lossesNow.resize(m_blockSize);
+  m_zNext.resize(m_blockSize);
+  m_tGamma.resize(m_blockSize);
+  m_rowOffset.resize(m_blockSize);
+  m_cumulativeRates.resize(m_interactions.size());
+  m_finalState.reserve(secondariesCapacity);
+
+  // particles left behind by a run interrupted by an exception are dropped
+  std::fill(m_alive.begin(), m_alive.end(), 0);
+  compact();
+  m_scalar.clear();
+  m_scalarPrimary.clear();
+
+  const auto nPrimaries = stack.size();
+  m_streams.clear();
+  m_streams.reserve(nPrimaries);
+  for (size_t i = 0; i < nPrimaries; ++i) m_streams.emplace_back(m_seed, i);
+
+  if (m_stats) m_stats->start(1, m_interactions.size(), nPrimaries);
+  const auto stats = m_stats ? m_stats->getThread(0) : nullptr;
+  try {
+    ParticleStack finished;
+    for (size_t i = 0; i < nPrimaries; ++i) push(stack[i], i, finished);
+    ParticleStack().swap(stack);
+    LOGD << "evolving ensemble of " << m_z.size() << " particles";
+
+    size_t sweeps = 0;
+    while (!m_z.empty()) {
+      if (stats) stats->peakStack.max(m_z.size());
+      // secondaries pushed during a sweep are advanced from the next one
+      const auto size = m_z.size();
+      for (size_t begin = 0; begin < size; begin += m_blockSize)
+        stepBlock(begin, std::min(begin + m_blockSize, size), finished, stats);
+      compact();
+      if (!m_observers.empty()) observe(finished);
+      sweeps++;
+    }
+    LOGD << "ensemble completed in " << sweeps << " sweeps";
+
+    if (!m_scalar.empty()) {
+      LOGD << "evolving " << m_scalar.size() << " particles outside the ensemble tables";
+      for (size_t i = 0; i < m_scalar.size(); ++i) {
+        ParticleStack cascade{m_scalar[i]};
+        m_streamRng.setCounterBased(m_streams[m_scalarPrimary[i]]);
+        evolveStack(cascade, m_streamRng, stats);
+        m_streams[m_scalarPrimary[i]] = m_streamRng.getCounterBased();
+        finished.insert(finished.end(), cascade.begin(), cascade.end());
+        if (!m_observers.empty()) observe(finished);
+      }
+      ParticleStack().swap(m_scalar);
+      std::vector<size_t>().swap(m_scalarPrimary);
+    }
+    if (stats) stats->primaries.add(nPrimaries);
+    stack.swap(finished);
+  } catch (...) {
+    if (m_stats) m_stats->stop();
+    throw;
+  }
+  if (m_stats) m_stats->stop();
+}
+
+}  // namespace evolutors
+}  // namespace simprop
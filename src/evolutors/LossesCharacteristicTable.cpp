@@ -0,0 +1,99 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/LossesCharacteristicTable.h"
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "simprop/utils/progressbar.h"
+
+namespace simprop {
+namespace evolutors {
+
+LossesCharacteristicTable::LossesCharacteristicTable(size_t lnGammaSize, size_t zSize)
+    : m_lnGammaSize(lnGammaSize), m_zSize(zSize) {
+  if (lnGammaSize < 2) throw std::runtime_error("ln Gamma axis size must be > 1");
+  if (zSize < 2) throw std::runtime_error("z axis size must be > 1");
+}
+
+void LossesCharacteristicTable::cacheTable(const std::function<double(double, double)>& betaDtdz,
+                                           Range GammaRange, Range zRange) {
+  m_lnGammaRange = {std::log(GammaRange.first), std::log(GammaRange.second)};
+  m_zRange = zRange;
+  m_dlnGamma = (m_lnGammaRange.second - m_lnGammaRange.first) / (double)(m_lnGammaSize - 1);
+  m_dz = (m_zRange.second - m_zRange.first) / (double)(m_zSize - 1);
+  m_table.assign(m_lnGammaSize * m_zSize, 0.);
+
+  auto progressbar = std::make_shared<utils::ProgressBar>(m_lnGammaSize);
+  auto progressbar_mutex = std::make_shared<std::mutex>();
+  progressbar->setMutex(progressbar_mutex);
+  progressbar->start("Start caching losses characteristic table");
+
+  // cumulative Simpson rule along z, one midpoint evaluation per cell
+  for (size_t i = 0; i < m_lnGammaSize; ++i) {
+    progressbar->update();
+    const auto Gamma = std::exp(m_lnGammaRange.first + (double)i * m_dlnGamma);
+    auto fLow = betaDtdz(Gamma, m_zRange.first);
+    double value = 0;
+    for (size_t j = 1; j < m_zSize; ++j) {
+      const auto zLow = m_zRange.first + (double)(j - 1) * m_dz;
+      const auto fMid = betaDtdz(Gamma, zLow + 0.5 * m_dz);
+      const auto fHigh = betaDtdz(Gamma, zLow + m_dz);
+      value += m_dz / 6. * (fLow + 4. * fMid + fHigh);
+      m_table[i * m_zSize + j] = value;
+      fLow = fHigh;
+    }
+  }
+}
+
+bool LossesCharacteristicTable::isInside(double Gamma, double z) const {
+  if (m_table.empty()) return false;
+  const auto lnGamma = std::log(Gamma);
+  return lnGamma >= m_lnGammaRange.first && lnGamma <= m_lnGammaRange.second &&
+         z >= m_zRange.first && z <= m_zRange.second;
+}
+
+void LossesCharacteristicTable::locateGamma(double Gamma, size_t& i, double& t) const {
+  const auto x = (std::log(Gamma) - m_lnGammaRange.first) / m_dlnGamma;
+  i = std::min((size_t)std::max(x, 0.), m_lnGammaSize - 2);
+  t = x - (double)i;
+}
+
+double LossesCharacteristicTable::getRow(size_t i, double t, size_t j) const {
+  return (1. - t) * m_table[i * m_zSize + j] + t * m_table[(i + 1) * m_zSize + j];
+}
+
+double LossesCharacteristicTable::get(double Gamma, double z) const {
+  size_t i;
+  double t;
+  locateGamma(Gamma, i, t);
+  const auto y = (z - m_zRange.first) / m_dz;
+  const auto j = std::min((size_t)std::max(y, 0.), m_zSize - 2);
+  const auto s = y - (double)j;
+  return (1. - s) * getRow(i, t, j) + s * getRow(i, t, j + 1);
+}
+
+double LossesCharacteristicTable::findRedshift(double Gamma, double value) const {
+  size_t i;
+  double t;
+  locateGamma(Gamma, i, t);
+  if (value <= getRow(i, t, 0)) return m_zRange.first;
+  if (value >= getRow(i, t, m_zSize - 1)) return m_zRange.second;
+  // B is monotonic in z, bisect for the first node above value
+  size_t lo = 0, hi = m_zSize - 1;
+  while (hi - lo > 1) {
+    const auto mid = (lo + hi) / 2;
+    if (getRow(i, t, mid) < value)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  const auto rLow = getRow(i, t, lo);
+  const auto rHigh = getRow(i, t, hi);
+  const auto s = (rHigh > rLow) ? (value - rLow) / (rHigh - rLow) : 0.;
+  return m_zRange.first + ((double)lo + s) * m_dz;
+}
+
+}  // namespace evolutors
+}  // namespace simprop
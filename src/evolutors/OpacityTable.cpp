@@ -0,0 +1,18 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/OpacityTable.h"
+
+#include <cmath>
+#include <limits>
+
+namespace simprop {
+namespace evolutors {
+
+double OpacityTable::sampleRedshiftInterval(double Gamma, double z, double r) const {
+  const auto value = get(Gamma, z) + std::log(1. - r);
+  // finite, release builds use -ffast-math which assumes no infinities
+  if (value <= get(Gamma, m_zRange.first)) return std::numeric_limits<double>::max();
+  return z - findRedshift(Gamma, value);
+}
+
+}  // namespace evolutors
+}  // namespace simprop
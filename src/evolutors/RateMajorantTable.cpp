@@ -0,0 +1,80 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/RateMajorantTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "simprop/utils/progressbar.h"
+
+namespace simprop {
+namespace evolutors {
+
+RateMajorantTable::RateMajorantTable(size_t lnGammaCells, size_t zCells, size_t subdivisions,
+                                     double safetyFactor)
+    : m_lnGammaCells(lnGammaCells),
+      m_zCells(zCells),
+      m_subdivisions(subdivisions),
+      m_safetyFactor(safetyFactor) {
+  if (lnGammaCells < 1 || zCells < 1) throw std::runtime_error("majorant needs at least one cell");
+  if (subdivisions < 1) throw std::runtime_error("majorant cells need at least one subdivision");
+  if (!(safetyFactor >= 1.)) throw std::runtime_error("majorant safety factor must be >= 1");
+}
+
+void RateMajorantTable::cacheTable(const std::function<double(double, double)>& rateDtdz,
+                                   Range GammaRange, Range zRange) {
+  m_lnGammaRange = {std::log(GammaRange.first), std::log(GammaRange.second)};
+  m_zRange = zRange;
+  m_dlnGamma = (m_lnGammaRange.second - m_lnGammaRange.first) / (double)m_lnGammaCells;
+  m_dz = (m_zRange.second - m_zRange.first) / (double)m_zCells;
+  m_table.assign(m_lnGammaCells * m_zCells, 0.);
+
+  auto progressbar = std::make_shared<utils::ProgressBar>(m_lnGammaCells);
+  auto progressbar_mutex = std::make_shared<std::mutex>();
+  progressbar->setMutex(progressbar_mutex);
+  progressbar->start("Start caching rate majorant table");
+
+  // values on the fine nodes, shared by the cells on both sides of a cell edge
+  const auto nGamma = m_lnGammaCells * m_subdivisions + 1;
+  const auto nz = m_zCells * m_subdivisions + 1;
+  const auto hlnGamma = m_dlnGamma / (double)m_subdivisions;
+  const auto hz = m_dz / (double)m_subdivisions;
+  std::vector<double> previous(nz), current(nz);
+  for (size_t k = 0; k < nGamma; ++k) {
+    if (k % m_subdivisions == 0) progressbar->update();
+    const auto Gamma = std::exp(m_lnGammaRange.first + (double)k * hlnGamma);
+    for (size_t l = 0; l < nz; ++l)
+      current[l] = std::fabs(rateDtdz(Gamma, m_zRange.first + (double)l * hz));
+    if (k > 0) {
+      const auto i = (k - 1) / m_subdivisions;
+      for (size_t l = 0; l + 1 < nz; ++l) {
+        const auto value = std::max(std::max(previous[l], previous[l + 1]),
+                                    std::max(current[l], current[l + 1]));
+        auto& cell = m_table[i * m_zCells + l / m_subdivisions];
+        cell = std::max(cell, m_safetyFactor * value);
+      }
+    }
+    previous.swap(current);
+  }
+}
+
+bool RateMajorantTable::isInside(double Gamma, double z) const {
+  if (m_table.empty()) return false;
+  const auto lnGamma = std::log(Gamma);
+  return lnGamma >= m_lnGammaRange.first && lnGamma <= m_lnGammaRange.second &&
+         z >= m_zRange.first && z <= m_zRange.second;
+}
+
+double RateMajorantTable::get(double Gamma, double zMin, double zMax) const {
+  const auto x = (std::log(Gamma) - m_lnGammaRange.first) / m_dlnGamma;
+  const auto i = std::min((size_t)std::max(x, 0.), m_lnGammaCells - 1);
+  const auto jMin = std::min((size_t)std::max((zMin - m_zRange.first) / m_dz, 0.), m_zCells - 1);
+  const auto jMax = std::min((size_t)std::max((zMax - m_zRange.first) / m_dz, 0.), m_zCells - 1);
+  const auto row = m_table.begin() + i * m_zCells;
+  return *std::max_element(row + jMin, row + jMax + 1);
+}
+
+}  // namespace evolutors
+}  // namespace simprop
@@ -0,0 +1,146 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/RunStats.h"
+
+#include <algorithm>
+
+#include "simprop/utils/io.h"
+#include "simprop/utils/logging.h"
+
+namespace simprop {
+namespace evolutors {
+
+RunStats::RunStats(double reportInterval) : m_reportInterval(reportInterval) {}
+
+RunStats::~RunStats() {
+  if (m_running) stop();
+}
+
+void RunStats::start(size_t nThreads, size_t nChannels, size_t nPrimaries) {
+  if (m_running) stop();
+  m_nPrimaries = nPrimaries;
+  m_threads.clear();
+  for (size_t i = 0; i < nThreads; ++i) m_threads.emplace_back(new ThreadStats(nChannels));
+  m_start = std::chrono::steady_clock::now();
+  m_running = true;
+  if (m_reportInterval > 0.) {
+    m_reporter = std::thread([this]() {
+      const auto interval = std::chrono::duration<double>(m_reportInterval);
+      std::unique_lock<std::mutex> lock(m_reporterMutex);
+      while (!m_reporterWakeup.wait_for(lock, interval, [this]() { return !m_running; }))
+        report();
+    });
+  }
+}
+
+void RunStats::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_reporterMutex);
+    m_running = false;
+    m_stop = std::chrono::steady_clock::now();
+  }
+  m_reporterWakeup.notify_all();
+  if (m_reporter.joinable()) m_reporter.join();
+  report();
+}
+
+uint64_t RunStats::sum(StatsCounter ThreadStats::*counter) const {
+  uint64_t value = 0;
+  for (const auto& thread : m_threads) value += ((*thread).*counter).get();
+  return value;
+}
+
+uint64_t RunStats::getPrimaries() const { return sum(&ThreadStats::primaries); }
+
+uint64_t RunStats::getSteps() const { return sum(&ThreadStats::steps); }
+
+uint64_t RunStats::getRateEvaluations() const { return sum(&ThreadStats::rateEvaluations); }
+
+uint64_t RunStats::getMajorantViolations() const { return sum(&ThreadStats::majorantViolations); }
+
+std::vector<uint64_t> RunStats::getInteractionsPerChannel() const {
+  std::vector<uint64_t> counts;
+  for (const auto& thread : m_threads) {
+    counts.resize(thread->interactionsPerChannel.size(), 0);
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += thread->interactionsPerChannel[i].get();
+  }
+  return counts;
+}
+
+uint64_t RunStats::getInteractions() const {
+  const auto counts = getInteractionsPerChannel();
+  uint64_t value = 0;
+  for (const auto& count : counts) value += count;
+  return value;
+}
+
+uint64_t RunStats::getRootFinderIterations() const {
+  return sum(&ThreadStats::rootFinderIterations);
+}
+
+uint64_t RunStats::getPeakStack() const {
+  uint64_t value = 0;
+  for (const auto& thread : m_threads) value = std::max(value, thread->peakStack.get());
+  return value;
+}
+
+double RunStats::getPhaseTime(ThreadStats::Phase phase) const {
+  uint64_t value = 0;
+  for (const auto& thread : m_threads) value += thread->nanoseconds[phase].get();
+  return 1e-9 * (double)value;
+}
+
+double RunStats::getElapsedTime() const {
+  const auto end = m_running ? std::chrono::steady_clock::now() : m_stop;
+  return std::chrono::duration<double>(end - m_start).count();
+}
+
+double RunStats::getParticlesPerSecond() const {
+  const auto elapsed = getElapsedTime();
+  const auto particles = getPrimaries() + sum(&ThreadStats::secondaries);
+  return (elapsed > 0.) ? (double)particles / elapsed : 0.;
+}
+
+void RunStats::report() const {
+  LOGI << "primaries " << getPrimaries() << "/" << m_nPrimaries << " steps " << getSteps()
+       << " rate evaluations " << getRateEvaluations() << " interactions " << getInteractions()
+       << " root finder iterations " << getRootFinderIterations() << " peak stack "
+       << getPeakStack() << " particles/s " << getParticlesPerSecond();
+  LOGI << "time in rates " << getPhaseTime(ThreadStats::rates) << " s, losses "
+       << getPhaseTime(ThreadStats::losses) << " s, final states "
+       << getPhaseTime(ThreadStats::finalState) << " s, elapsed " << getElapsedTime() << " s";
+  // interactions are undersampled wherever the rate exceeds its bound
+  if (getMajorantViolations() > 0) {
+    LOGW << "rate above the majorant at " << getMajorantViolations() << " candidates";
+  }
+}
+
+void RunStats::dump(const std::string& filename) const {
+  utils::OutputFile out(filename);
+  out << "{\n";
+  out << "  \"threads\": " << m_threads.size() << ",\n";
+  out << "  \"primaries\": " << getPrimaries() << ",\n";
+  out << "  \"steps\": " << getSteps() << ",\n";
+  out << "  \"rateEvaluations\": " << getRateEvaluations() << ",\n";
+  out << "  \"majorantViolations\": " << getMajorantViolations() << ",\n";
+  out << "  \"interactions\": " << getInteractions() << ",\n";
+  out << "  \"interactionsPerChannel\": [";
+  const auto channels = getInteractionsPerChannel();
+  for (size_t i = 0; i < channels.size(); ++i) out << (i > 0 ? ", " : "") << channels[i];
+  out << "],\n";
+  out << "  \"secondaries\": " << sum(&ThreadStats::secondaries) << ",\n";
+  out << "  \"rootFinderIterations\": " << getRootFinderIterations() << ",\n";
+  out << "  \"peakStack\": " << getPeakStack() << ",\n";
+  out << "  \"timeRates\": " << getPhaseTime(ThreadStats::rates) << ",\n";
+  out << "  \"timeLosses\": " << getPhaseTime(ThreadStats::losses) << ",\n";
+  out << "  \"timeFinalState\": " << getPhaseTime(ThreadStats::finalState) << ",\n";
+  out << "  \"elapsedTime\": " << getElapsedTime() << ",\n";
+  out << "  \"particlesPerSecond\": " << getParticlesPerSecond() << ",\n";
+  out << "  \"stepsPerThread\": [";
+  for (size_t i = 0; i < m_threads.size(); ++i)
+    out << (i > 0 ? ", " : "") << m_threads[i]->steps.get();
+  out << "]\n";
+  out << "}\n";
+}
+
+}  // namespace evolutors
+}  // namespace simprop
@@ -1,6 +1,14 @@
-#include "simprop/evolutors/singleProtonEvolutor.h"
+#include "simprop/evolutors/SingleProtonEvolutor.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
@@ -10,18 +18,28 @@
 namespace simprop {
 namespace evolutors {
 
-auto IsActive = [](const Particle& p) {
-  constexpr double minPropagatingGamma = 1e6;
-  return (p.isNucleus() && p.isActive() && p.getRedshift() > 1e-20 &&
+constexpr double SingleProtonEvolutor::minPropagatingGamma;
+constexpr double SingleProtonEvolutor::minPropagatingRedshift;
+constexpr size_t SingleProtonEvolutor::secondariesCapacity;
+
+bool SingleProtonEvolutor::IsActive(const Particle& p) {
+  return (p.isNucleus() && p.isActive() && p.getRedshift() > minPropagatingRedshift &&
           p.getGamma() > minPropagatingGamma);
-};
+}
 
-SingleProtonEvolutor::SingleProtonEvolutor(RandomNumberGenerator& rng) : m_rng(rng) {}
+SingleProtonEvolutor::SingleProtonEvolutor(RandomNumberGenerator& rng)
+    : m_rng(rng) {}
 
 double SingleProtonEvolutor::totalLosses(PID pid, double Gamma, double z) const {
+  const auto it = m_totalLossesTables.find(pid);
+  if (it != m_totalLossesTables.end()) {
+    const auto lnGamma = std::log(Gamma);
+    if (it->second.xIsInside(lnGamma) && it->second.yIsInside(z))
+      return it->second.get(lnGamma, z);
+  }
   return std::accumulate(
       m_continuousLosses.begin(), m_continuousLosses.end(), 0.,
-      [pid, Gamma, z](double beta, std::shared_ptr<losses::ContinuousLosses> losses) {
+      [pid, Gamma, z](double beta, const std::shared_ptr<losses::ContinuousLosses>& losses) {
         return beta + losses->beta(pid, Gamma, z);
       });
 }
@@ -29,11 +47,106 @@ double SingleProtonEvolutor::totalLosses(PID pid, double Gamma, double z) const
 double SingleProtonEvolutor::totalRate(PID pid, double Gamma, double z) const {
   return std::accumulate(
       m_interactions.begin(), m_interactions.end(), 0.,
-      [pid, Gamma, z](double rate, std::shared_ptr<interactions::Interaction> interaction) {
+      [pid, Gamma, z](double rate,
+                      const std::shared_ptr<interactions::Interaction>& interaction) {
         return rate + interaction->rate(pid, Gamma, z);
       });
 }
 
+void SingleProtonEvolutor::doCachingTotalLosses(const std::vector<PID>& species) {
+  for (const auto& pid : species) {
+    LOGD << "caching total losses table for " << getPidName(pid);
+    // sampled while no table is registered, so that the losses themselves are summed
+    m_totalLossesTables.erase(pid);
+    utils::LookupTable<2000, 200> table;
+    table.cacheTable(
+        [this, pid](double lnGamma, double z) { return totalLosses(pid, std::exp(lnGamma), z); },
+        {std::log(m_tablesGammaRange.first), std::log(m_tablesGammaRange.second)},
+        m_tablesRedshiftRange);
+    m_totalLossesTables[pid] = std::move(table);
+  }
+}
+
+void SingleProtonEvolutor::doCachingLosses(const std::vector<PID>& species) {
+  if (!m_cosmology) throw std::runtime_error("cosmology must be added before caching losses");
+  for (const auto& pid : species) {
+    LOGD << "caching losses characteristic table for " << getPidName(pid);
+    LossesCharacteristicTable table;
+    table.cacheTable(
+        [this, pid](double Gamma, double z) {
+          return totalLosses(pid, Gamma, z) * m_cosmology->dtdz(z);
+        },
+        m_tablesGammaRange, m_tablesRedshiftRange);
+    m_lossesTables[pid] = std::move(table);
+  }
+}
+
+void SingleProtonEvolutor::dropTables(bool isLosses, bool isRates) {
+  const auto isCached = (isLosses && !(m_totalLossesTables.empty() && m_lossesTables.empty())) ||
+                        (isRates && !(m_rateMajorants.empty() && m_opacityTables.empty()));
+  if (isCached) {
+    LOGW << "dropping the tables cached before the evolutor setup changed";
+  }
+  if (isLosses) {
+    m_totalLossesTables.clear();
+    m_lossesTables.clear();
+  }
+  if (isRates) {
+    m_rateMajorants.clear();
+    m_opacityTables.clear();
+  }
+}
+
+void SingleProtonEvolutor::doCachingRateMajorants(const std::vector<PID>& species) {
+  if (!m_cosmology) throw std::runtime_error("cosmology must be added before caching majorants");
+  for (const auto& pid : species) {
+    LOGD << "caching rate majorant table for " << getPidName(pid);
+    RateMajorantTable table;
+    table.cacheTable(
+        [this, pid](double Gamma, double z) {
+          return totalRate(pid, Gamma, z) * m_cosmology->dtdz(z);
+        },
+        m_tablesGammaRange, m_tablesRedshiftRange);
+    m_rateMajorants[pid] = std::move(table);
+  }
+}
+
+void SingleProtonEvolutor::doCachingOpacities(const std::vector<PID>& species) {
+  if (!m_cosmology) throw std::runtime_error("cosmology must be added before caching opacities");
+  for (const auto& pid : species) {
+    LOGD << "caching opacity table for " << getPidName(pid);
+    OpacityTable table;
+    table.cacheTable(
+        [this, pid](double Gamma, double z) {
+          return std::fabs(totalRate(pid, Gamma, z)) * m_cosmology->dtdz(z);
+        },
+        m_tablesGammaRange, m_tablesRedshiftRange);
+    m_opacityTables[pid] = std::move(table);
+  }
+}
+
+const OpacityTable* SingleProtonEvolutor::findOpacityTable(const Particle& particle) const {
+  const auto it = m_opacityTables.find(particle.getPid());
+  if (it == m_opacityTables.end()) return nullptr;
+  if (!it->second.isInside(particle.getGamma(), particle.getRedshift())) return nullptr;
+  return &it->second;
+}
+
+const RateMajorantTable* SingleProtonEvolutor::findRateMajorant(const Particle& particle) const {
+  const auto it = m_rateMajorants.find(particle.getPid());
+  if (it == m_rateMajorants.end()) return nullptr;
+  if (!it->second.isInside(particle.getGamma(), particle.getRedshift())) return nullptr;
+  return &it->second;
+}
+
+const LossesCharacteristicTable* SingleProtonEvolutor::findLossesTable(
+    const Particle& particle) const {
+  const auto it = m_lossesTables.find(particle.getPid());
+  if (it == m_lossesTables.end()) return nullptr;
+  if (!it->second.isInside(particle.getGamma(), particle.getRedshift())) return nullptr;
+  return &it->second;
+}
+
 double SingleProtonEvolutor::computeDeltaGamma(const Particle& particle,
                                                double deltaRedshift) const {
   const auto pid = particle.getPid();
@@ -43,6 +156,12 @@ double SingleProtonEvolutor::computeDeltaGamma(const Particle& particle,
   const auto zHalf = zNow - 0.5 * deltaRedshift;
   const auto zNext = zNow - deltaRedshift;
 
+  const auto table = findLossesTable(particle);
+  if (table) {
+    const auto value = table->get(Gamma, zNow) - table->get(Gamma, zNext);
+    return 1.0 - std::exp(-value);
+  }
+
   const auto betaNow = totalLosses(pid, Gamma, zNow);
   const auto betaHalf = totalLosses(pid, Gamma, zHalf);
   const auto betaNext = totalLosses(pid, Gamma, zNext);
@@ -55,6 +174,13 @@ double SingleProtonEvolutor::computeDeltaGamma(const Particle& particle,
 
 double SingleProtonEvolutor::computeLossesRedshiftInterval(const Particle& particle) const {
   const auto zNow = particle.getRedshift();
+  const auto table = findLossesTable(particle);
+  if (table) {
+    // invert B(Gamma, zNext) = B(Gamma, zNow) + ln(1 - deltaGammaCritical)
+    const auto Gamma = particle.getGamma();
+    const auto value = table->get(Gamma, zNow) + std::log(1. - deltaGammaCritical);
+    return zNow - table->findRedshift(Gamma, value);
+  }
   const auto deltaGamma = computeDeltaGamma(particle, zNow);
   double dz = zNow;
   if (deltaGamma > deltaGammaCritical) {
@@ -65,13 +191,60 @@ double SingleProtonEvolutor::computeLossesRedshiftInterval(const Particle& parti
   return dz;
 }
 
-double SingleProtonEvolutor::computeInteractionRedshiftInterval(const Particle& particle) const {
+double SingleProtonEvolutor::computeRates(const Particle& particle,
+                                          std::vector<double>& cumulativeRates) const {
+  return computeRates(particle, particle.getRedshift(), cumulativeRates);
+}
+
+double SingleProtonEvolutor::computeRates(const Particle& particle, double z,
+                                          std::vector<double>& cumulativeRates) const {
   const auto pid = particle.getPid();
   const auto Gamma = particle.getGamma();
+  double rate = 0;
+  for (size_t i = 0; i < m_interactions.size(); ++i) {
+    rate += m_interactions[i]->rate(pid, Gamma, z);
+    cumulativeRates[i] = rate;
+  }
+  return rate;
+}
+
+double SingleProtonEvolutor::computeInteractionRedshiftInterval(const Particle& particle,
+                                                                double rate,
+                                                                RandomNumberGenerator& rng) const {
   const auto zNow = particle.getRedshift();
-  const auto dt = std::fabs(1. / totalRate(pid, Gamma, zNow));
+  const auto dt = std::fabs(1. / rate);
   // TODO why to put the fabs?
-  return -dt / m_cosmology->dtdz(zNow) * std::log(1. - m_rng());
+  return -dt / m_cosmology->dtdz(zNow) * std::log(1. - rng());
+}
+
+double SingleProtonEvolutor::sampleNullCollisions(const RateMajorantTable& majorant,
+                                                  const Particle& particle, double dzMax,
+                                                  std::vector<double>& cumulativeRates,
+                                                  RandomNumberGenerator& rng,
+                                                  ThreadStats* stats) const {
+  const auto zNow = particle.getRedshift();
+  const auto bound = majorant.get(particle.getGamma(), zNow - dzMax, zNow);
+  // a finite sentinel, release builds use -ffast-math which assumes no infinities
+  if (!(bound > 0.)) return std::numeric_limits<double>::max();
+  // candidates follow the constant bound, the exact rate is only evaluated to thin them
+  auto dz = 0.;
+  while (true) {
+    dz -= std::log(1. - rng()) / bound;
+    if (dz > dzMax) return dz;
+    const auto z = zNow - dz;
+    if (stats) stats->rateEvaluations.add();
+    const auto rate = computeRates(particle, z, cumulativeRates) * std::fabs(m_cosmology->dtdz(z));
+    if (stats && rate > bound) stats->majorantViolations.add();
+    if (rng() * bound < rate) return dz;
+  }
+}
+
+size_t SingleProtonEvolutor::sampleInteraction(const std::vector<double>& cumulativeRates,
+                                               RandomNumberGenerator& rng) const {
+  if (cumulativeRates.size() == 1) return 0;
+  const auto r = rng() * cumulativeRates.back();
+  const auto it = std::upper_bound(cumulativeRates.begin(), cumulativeRates.end(), r);
+  return std::min<size_t>(it - cumulativeRates.begin(), cumulativeRates.size() - 1);
 }
 
 // void SingleProtonEvolutor::run(ParticleStack& stack) {
@@ -89,31 +262,326 @@ double SingleProtonEvolutor::computeInteractionRedshiftInterval(const Particle&
 //   }
 // }  // run()
 
-void SingleProtonEvolutor::run(ParticleStack& stack) {
-  size_t counter = 0;
-  auto it = stack.begin();
-  // size_t iniSize = stack.size();
-  // const double initEnergy = sumEnergy();
-  while (it != stack.end()) {
-    const auto distance = it - stack.begin();
-    const auto nowRedshift = it->getRedshift();
-    const auto dz_s = computeInteractionRedshiftInterval(*it);
-    const auto dz_c = computeLossesRedshiftInterval(*it);
+void SingleProtonEvolutor::observe(ParticleStack& particles) const {
+  for (const auto& observer : m_observers)
+    for (const auto& particle : particles) observer->observe(particle);
+  ParticleStack().swap(particles);
+}
+
+void SingleProtonEvolutor::evolveStack(ParticleStack& stack, RandomNumberGenerator& rng,
+                                       ThreadStats* stats) const {
+  // particles still to be propagated are kept in a LIFO worklist, everything else is finished
+  ParticleStack active;
+  ParticleStack finished;
+  for (const auto& particle : stack)
+    if (!IsActive(particle)) finished.push_back(particle);
+  for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+    if (IsActive(*it)) active.push_back(*it);
+
+  // rates are evaluated once per step and drive both the step size and the channel choice
+  std::vector<double> cumulativeRates(m_interactions.size());
+  // secondaries of one interaction, reused so that interactions do not allocate
+  std::vector<Particle> finalState;
+  finalState.reserve(secondariesCapacity);
+
+  // the input copy is released, only the in-flight particles are kept from now on
+  ParticleStack().swap(stack);
+  while (!active.empty()) {
+    if (stats) {
+      stats->steps.add();
+      stats->peakStack.max(active.size());
+    }
+    auto& particle = active.back();
+    const auto nowRedshift = particle.getRedshift();
+    const auto opacity = findOpacityTable(particle);
+    const auto majorant = opacity ? nullptr : findRateMajorant(particle);
+    double dz_s = 0, dz_c = 0;
+    if (opacity) {
+      PhaseTimer lossesTimer(stats, ThreadStats::losses);
+      dz_c = computeLossesRedshiftInterval(particle);
+      lossesTimer.stop();
+      PhaseTimer ratesTimer(stats, ThreadStats::rates);
+      dz_s = opacity->sampleRedshiftInterval(particle.getGamma(), nowRedshift, rng());
+      // the rates are needed only for the channel choice at the interaction point
+      if (dz_s <= dz_c && dz_s <= nowRedshift) {
+        if (stats) stats->rateEvaluations.add();
+        computeRates(particle, nowRedshift - dz_s, cumulativeRates);
+      }
+    } else if (majorant) {
+      // the losses step bounds the segment on which the candidates are sampled
+      PhaseTimer lossesTimer(stats, ThreadStats::losses);
+      dz_c = computeLossesRedshiftInterval(particle);
+      lossesTimer.stop();
+      PhaseTimer ratesTimer(stats, ThreadStats::rates);
+      dz_s = sampleNullCollisions(*majorant, particle, dz_c, cumulativeRates, rng, stats);
+    } else {
+      PhaseTimer ratesTimer(stats, ThreadStats::rates);
+      if (stats) stats->rateEvaluations.add();
+      const auto rate = computeRates(particle, cumulativeRates);
+      dz_s = computeInteractionRedshiftInterval(particle, rate, rng);
+      ratesTimer.stop();
+      PhaseTimer lossesTimer(stats, ThreadStats::losses);
+      dz_c = computeLossesRedshiftInterval(particle);
+    }
+    PhaseTimer lossesTimer(stats, ThreadStats::losses);
     assert(dz_s > 0. && dz_c > 0. && dz_c <= nowRedshift);
     if (dz_s > dz_c || dz_s > nowRedshift) {
-      const auto Gamma = it->getGamma();
+      const auto Gamma = particle.getGamma();
       const auto dz = dz_c;
-      const auto deltaGamma = computeDeltaGamma(*it, dz);
-      it->getNow() = {nowRedshift - dz, Gamma * (1. - deltaGamma)};
+      const auto deltaGamma = computeDeltaGamma(particle, dz);
+      lossesTimer.stop();
+      particle.getNow() = {nowRedshift - dz, Gamma * (1. - deltaGamma)};
+      if (!IsActive(particle)) {
+        finished.push_back(particle);
+        active.pop_back();
+      }
     } else {
-      it->deactivate();
+      lossesTimer.stop();
+      particle.deactivate();
       const auto dz = dz_s;
-      auto finalState = m_interactions[0]->finalState(*it, nowRedshift - dz, m_rng);
-      stack.insert(stack.end(), finalState.begin(), finalState.end());
+      const auto channel = sampleInteraction(cumulativeRates, rng);
+      PhaseTimer finalStateTimer(stats, ThreadStats::finalState);
+      finalState.clear();
+      m_interactions[channel]->finalState(particle, nowRedshift - dz, rng, finalState);
+      if (m_weightWindow) m_weightWindow->apply(finalState, rng);
+      finalStateTimer.stop();
+      if (stats) {
+        stats->interactionsPerChannel[channel].add();
+        stats->secondaries.add(finalState.size());
+      }
+      finished.push_back(particle);
+      active.pop_back();
+      for (const auto& secondary : finalState) {
+        if (IsActive(secondary))
+          active.push_back(secondary);
+        else
+          finished.push_back(secondary);
+      }
+    }
+  }
+  stack.swap(finished);
+}  // evolveStack()
+
+void SingleProtonEvolutor::evolvePrimary(const Particle& primary, size_t iPrimary,
+                                         ParticleStack& finished, ThreadStats* stats) const {
+  // every primary draws from its own counter-based stream, so that its cascade does not depend
+  // on which thread evolves it or on the primaries evolved before
+  RandomNumberGenerator rng = utils::RNG<double>(m_seed, iPrimary);
+  ParticleStack cascade{primary};
+  const auto iterations = utils::rootFinderIterations();
+  evolveStack(cascade, rng, stats);
+  finished.insert(finished.end(), cascade.begin(), cascade.end());
+  if (stats) {
+    stats->primaries.add();
+    stats->rootFinderIterations.add(utils::rootFinderIterations() - iterations);
+  }
+}
+
+ParticleStack SingleProtonEvolutor::replay(const Particle& primary, size_t iPrimary) const {
+  ParticleStack cascade;
+  evolvePrimary(primary, iPrimary, cascade);
+  return cascade;
+}
+
+void SingleProtonEvolutor::runParallel(ParticleStack& stack, size_t nThreads,
+                                       Checkpoint* checkpoint) {
+  const auto nPrimaries = stack.size();
+  // a resumed run continues the primary numbering, so that every primary keeps its stream
+  const size_t firstPrimary = checkpoint ? checkpoint->nextPrimary : 0;
+
+  // every primary starts its own cascade, the initial partition is interleaved so that the
+  // primaries in flight stay close to each other in order
+  std::vector<std::deque<size_t>> queues(nThreads);
+  std::vector<std::mutex> queueMutexes(nThreads);
+  for (size_t i = 0; i < nPrimaries; ++i) queues[i % nThreads].push_back(i);
+
+  std::vector<ParticleStack> cascades(nPrimaries);
+  std::exception_ptr failure = nullptr;
+  std::mutex failureMutex;
+
+  // finished cascades are handed to the observers in primary order, a cascade completed ahead of
+  // an earlier one waits for it, so that the output does not depend on scheduling
+  std::vector<char> isFinished(nPrimaries, 0);
+  size_t nextObserved = 0;
+  bool isStopped = false;
+  std::mutex observersMutex;
+  std::condition_variable observedAdvanced;
+  auto handOver = [&](size_t iPrimary) {
+    std::lock_guard<std::mutex> lock(observersMutex);
+    isFinished[iPrimary] = 1;
+    const auto firstObserved = nextObserved;
+    for (; nextObserved < nPrimaries && isFinished[nextObserved]; ++nextObserved)
+      observe(cascades[nextObserved]);
+    if (nextObserved == firstObserved) return;
+    observedAdvanced.notify_all();
+    // the observed primaries are a contiguous prefix, the checkpoint keeps the others pending
+    const auto interval = m_checkpointInterval;
+    if (checkpoint && nextObserved < nPrimaries &&
+        (firstPrimary + nextObserved) / interval > (firstPrimary + firstObserved) / interval)
+      saveCheckpoint(*checkpoint, stack, firstPrimary, nextObserved);
+  };
+
+  // the cascades waiting for a slow primary are held in memory, so with observers a worker does
+  // not start a primary more than maxAhead past the first unobserved one until it is observed
+  const auto maxAhead = m_observers.empty() ? nPrimaries : 8 * nThreads;
+
+  // a worker pops from the front of its own queue and steals from the back of the others, or from
+  // their front when the back is too far ahead
+  auto nextPrimary = [&](size_t id, size_t& iPrimary) {
+    while (true) {
+      size_t limit = nPrimaries;
+      if (!m_observers.empty()) {
+        std::lock_guard<std::mutex> lock(observersMutex);
+        if (isStopped) return false;
+        limit = nextObserved + maxAhead;
+      }
+      bool isEmpty = true;
+      for (size_t k = 0; k < nThreads; ++k) {
+        const auto victim = (id + k) % nThreads;
+        std::lock_guard<std::mutex> lock(queueMutexes[victim]);
+        auto& queue = queues[victim];
+        if (queue.empty()) continue;
+        isEmpty = false;
+        if (k > 0 && queue.back() < limit) {
+          iPrimary = queue.back();
+          queue.pop_back();
+          return true;
+        }
+        if (queue.front() < limit) {
+          iPrimary = queue.front();
+          queue.pop_front();
+          return true;
+        }
+      }
+      if (isEmpty) return false;
+      // every primary left is too far ahead, the first unobserved one is being evolved
+      std::unique_lock<std::mutex> lock(observersMutex);
+      observedAdvanced.wait(lock, [&] { return isStopped || nextObserved + maxAhead > limit; });
+    }
+  };
+
+  auto worker = [&](size_t id) {
+    size_t iPrimary;
+    try {
+      auto stats = m_stats ? m_stats->getThread(id) : nullptr;
+      while (nextPrimary(id, iPrimary)) {
+        evolvePrimary(stack[iPrimary], firstPrimary + iPrimary, cascades[iPrimary], stats);
+        if (!m_observers.empty()) handOver(iPrimary);
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (!failure) failure = std::current_exception();
+      }
+      // the primary that failed is never observed, release the workers waiting for it
+      std::lock_guard<std::mutex> lock(observersMutex);
+      isStopped = true;
+      observedAdvanced.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nThreads);
+  for (size_t id = 0; id < nThreads; ++id) threads.emplace_back(worker, id);
+  for (auto& t : threads) t.join();
+  if (failure) std::rethrow_exception(failure);
+
+  // merge the cascades in primary order so that the output layout does not depend on scheduling
+  const auto size = std::accumulate(cascades.begin(), cascades.end(), size_t(0),
+                                    [](size_t n, const ParticleStack& c) { return n + c.size(); });
+  ParticleStack merged;
+  merged.reserve(size);
+  for (auto& cascade : cascades) {
+    merged.insert(merged.end(), cascade.begin(), cascade.end());
+    ParticleStack().swap(cascade);
+  }
+  stack.swap(merged);
+}  // runParallel()
+
+void SingleProtonEvolutor::setCheckpoint(const std::string& filename, size_t interval) {
+  if (interval == 0) throw std::invalid_argument("checkpoint interval must be positive");
+  m_checkpointFilename = filename;
+  m_checkpointInterval = interval;
+}
+
+void SingleProtonEvolutor::saveCheckpoint(Checkpoint& checkpoint, const ParticleStack& stack,
+                                          size_t firstPrimary, size_t nObserved) const {
+  checkpoint.nextPrimary = firstPrimary + nObserved;
+  checkpoint.pending.assign(stack.begin() + nObserved, stack.end());
+  checkpoint.seed = m_seed;
+  checkpoint.rngState = m_rng.getState();
+  checkpoint.observersState.clear();
+  for (const auto& observer : m_observers) {
+    std::ostringstream state;
+    observer->save(state);
+    checkpoint.observersState.push_back(state.str());
+  }
+  checkpoint.save(m_checkpointFilename);
+}
+
+size_t SingleProtonEvolutor::resolveThreads(size_t nPrimaries) const {
+  const auto nThreads =
+      (m_nThreads > 0) ? m_nThreads : (size_t)std::thread::hardware_concurrency();
+  return std::max(std::min(nThreads, nPrimaries), size_t(1));
+}
+
+void SingleProtonEvolutor::resume(const std::string& filename, ParticleStack& stack) {
+  if (m_observers.empty()) throw std::runtime_error("checkpointed runs need observers");
+  auto checkpoint = Checkpoint::load(filename);
+  if (checkpoint.observersState.size() != m_observers.size())
+    throw std::runtime_error("checkpoint does not match the registered observers");
+  if (m_checkpointFilename.empty()) setCheckpoint(filename);
+  m_rng.setState(checkpoint.rngState);
+  m_seed = checkpoint.seed;
+  for (size_t i = 0; i < m_observers.size(); ++i) {
+    std::istringstream state(checkpoint.observersState[i]);
+    m_observers[i]->load(state);
+  }
+  LOGD << "resuming from primary " << checkpoint.nextPrimary << " of " << checkpoint.nPrimaries;
+  ParticleStack pending;
+  pending.swap(checkpoint.pending);
+  const auto nThreads = resolveThreads(pending.size());
+  if (m_stats) m_stats->start(nThreads, m_interactions.size(), pending.size());
+  try {
+    runParallel(pending, nThreads, &checkpoint);
+  } catch (...) {
+    if (m_stats) m_stats->stop();
+    throw;
+  }
+  if (m_stats) m_stats->stop();
+  stack.swap(pending);
+}  // resume()
+
+void SingleProtonEvolutor::run(ParticleStack& stack) {
+  if (!m_hasSeed) m_seed = static_cast<uint64_t>(m_rng() * 9007199254740992.);
+  LOGI << "evolving " << stack.size() << " primaries with seed " << m_seed;
+  // the finished particles are not kept in the checkpoint, only what the observers saved
+  if (!m_checkpointFilename.empty() && m_observers.empty())
+    throw std::runtime_error("checkpointed runs need observers");
+  const auto nThreads = resolveThreads(stack.size());
+  LOGD << "using " << nThreads << " threads";
+  if (m_stats) m_stats->start(nThreads, m_interactions.size(), stack.size());
+  try {
+    if (!m_checkpointFilename.empty()) {
+      Checkpoint checkpoint;
+      checkpoint.nPrimaries = stack.size();
+      runParallel(stack, nThreads, &checkpoint);
+    } else if (nThreads == 1) {
+      ParticleStack finished;
+      const auto stats = m_stats ? m_stats->getThread(0) : nullptr;
+      for (size_t i = 0; i < stack.size(); ++i) {
+        evolvePrimary(stack[i], i, finished, stats);
+        if (!m_observers.empty()) observe(finished);
+      }
+      stack.swap(finished);
+    } else {
+      runParallel(stack, nThreads);
     }
-    it = std::find_if(stack.begin() + distance, stack.end(), IsActive);
-    counter++;
+  } catch (...) {
+    if (m_stats) m_stats->stop();
+    throw;
   }
+  if (m_stats) m_stats->stop();
 }  // run()
 
 // double SingleProtonEvolutor::getObservedEnergy() const {
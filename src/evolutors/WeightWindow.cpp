@@ -0,0 +1,62 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/evolutors/WeightWindow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace simprop {
+namespace evolutors {
+
+WeightWindow::WeightWindow(size_t maxSplitting) : m_maxSplitting(maxSplitting) {
+  if (maxSplitting < 1) throw std::invalid_argument("maximum splitting must be at least one");
+}
+
+void WeightWindow::add(PID pid, Range energyRange, double lower, double upper, double survival) {
+  if (!(lower > 0.) || !(upper > lower))
+    throw std::invalid_argument("weight window bounds must satisfy 0 < lower < upper");
+  if (survival == 0.) survival = 0.5 * (lower + upper);
+  if (survival < lower || survival > upper)
+    throw std::invalid_argument("survival weight must lie inside the window");
+  m_windows.push_back({pid, energyRange, lower, upper, survival});
+}
+
+double WeightWindow::getParticleEnergy(const Particle& particle) {
+  const auto mass = getPidMass(particle.getPid());
+  return (mass > 0.) ? particle.getGamma() * mass : particle.getGamma();
+}
+
+const WeightWindow::Window* WeightWindow::find(const Particle& particle) const {
+  for (const auto& window : m_windows) {
+    if (!(window.pid == particle.getPid())) continue;
+    const auto E = getParticleEnergy(particle);
+    if (E >= window.energyRange.first && E < window.energyRange.second) return &window;
+  }
+  return nullptr;
+}
+
+void WeightWindow::apply(std::vector<Particle>& particles, RandomNumberGenerator& rng) const {
+  // survivors are compacted in place, split copies are appended after the original particles
+  const auto size = particles.size();
+  size_t last = 0;
+  for (size_t i = 0; i < size; ++i) {
+    auto particle = particles[i];
+    const auto window = find(particle);
+    if (window) {
+      const auto w = particle.getWeight();
+      if (w < window->lower) {
+        if (rng() * window->survival >= w) continue;
+        particle.setWeight(window->survival);
+      } else if (w > window->upper) {
+        const auto n = std::min((size_t)std::ceil(w / window->upper), m_maxSplitting);
+        particle.setWeight(w / (double)n);
+        for (size_t k = 1; k < n; ++k) particles.push_back(particle);
+      }
+    }
+    particles[last++] = particle;
+  }
+  particles.erase(particles.begin() + last, particles.begin() + size);
+}
+
+}  // namespace evolutors
+}  // namespace simprop
@@ -1,13 +1,28 @@
 #include "simprop/interactions/PhotoDisintegration.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
+#include "simprop/utils/registry.h"
 
 namespace simprop {
 namespace interactions {
 
+namespace {
+
+// points of the Simpson rule over ln eps', even as required by the rule
+constexpr size_t simpsonIntervals = 300;
+
+// rates are tabulated in log, smaller rates are stored as this floor and returned as zero
+constexpr double minRate = 1e-300;
+
+}  // namespace
+
 PhotoDisintegration::PhotoDisintegration(const std::shared_ptr<photonfields::PhotonField>& phField)
-    : Interaction(phField) {
+    : Interaction(phField),
+      m_xs(utils::DataRegistry::get<xsecs::PhotoDisintegrationTalysXsec>()) {
   LOGD << "calling " << __func__ << " constructor";
 }
 
@@ -15,28 +30,201 @@ double PhotoDisintegration::interactionLength(PID pid, double Gamma) const {
   return SI::cLight * getPidNucleusMassNumber(pid) / rate(pid, Gamma);
 }
 
-double PhotoDisintegration::rate(PID pid, double Gamma, double z) const {
+Range PhotoDisintegration::getLnEpsPrimeRange(double Gamma) const {
+  // the integration is clipped to the support of the TALYS cross sections
+  const auto epsPrimeRange = m_xs->getEpsPrimeRange();
+  const auto epsPrimeMin = std::max({m_xs->getEpsPrimeThreshold(), epsPrimeRange.first,
+                                     2. * Gamma * m_phField->getMinPhotonEnergy()});
+  const auto epsPrimeMax =
+      std::min(epsPrimeRange.second, 2. * Gamma * m_phField->getMaxPhotonEnergy());
+  return {std::log(epsPrimeMin), std::log(epsPrimeMax)};
+}
+
+double PhotoDisintegration::getChannelXsec(PID pid, double epsPrime, size_t channel) const {
+  return (channel == 0) ? m_xs->getSingleNucleon(pid, epsPrime) : m_xs->getAlpha(pid, epsPrime);
+}
+
+double PhotoDisintegration::computeRate(PID pid, double Gamma, double z) const {
   auto value = double(0);
-  auto threshold = m_xs.getEpsPrimeThreshold();
-  auto lnEpsPrimeMin = std::log(std::max(threshold, 2. * Gamma * m_phField->getMinPhotonEnergy()));
-  auto lnEpsPrimeMax = std::log(2. * Gamma * m_phField->getMaxPhotonEnergy());
-  if (lnEpsPrimeMax > lnEpsPrimeMin) {
+  const auto lnEpsPrimeRange = getLnEpsPrimeRange(Gamma);
+  if (lnEpsPrimeRange.second > lnEpsPrimeRange.first) {
     value = utils::simpsonIntegration<double>(
         [this, pid, Gamma, z](double lnEpsPrime) {
           auto epsPrime = std::exp(lnEpsPrime);
-          return epsPrime * epsPrime * m_xs.getAtEpsPrime(pid, epsPrime) *
+          return epsPrime * epsPrime * m_xs->getAtEpsPrime(pid, epsPrime) *
+                 m_phField->I_gamma(epsPrime / 2. / Gamma, z);
+        },
+        lnEpsPrimeRange.first, lnEpsPrimeRange.second, simpsonIntervals);
+    value *= SI::cLight / 2. / pow2(Gamma);
+  }
+  return std::max(value, 0.);
+}
+
+double PhotoDisintegration::computeChannelRate(PID pid, double Gamma, double z,
+                                               size_t channel) const {
+  auto value = double(0);
+  const auto lnEpsPrimeRange = getLnEpsPrimeRange(Gamma);
+  if (lnEpsPrimeRange.second > lnEpsPrimeRange.first) {
+    value = utils::simpsonIntegration<double>(
+        [this, pid, Gamma, z, channel](double lnEpsPrime) {
+          auto epsPrime = std::exp(lnEpsPrime);
+          return epsPrime * epsPrime * getChannelXsec(pid, epsPrime, channel) *
                  m_phField->I_gamma(epsPrime / 2. / Gamma, z);
         },
-        lnEpsPrimeMin, lnEpsPrimeMax, 300);
+        lnEpsPrimeRange.first, lnEpsPrimeRange.second, simpsonIntervals);
     value *= SI::cLight / 2. / pow2(Gamma);
   }
   return std::max(value, 0.);
 }
 
-std::vector<Particle> PhotoDisintegration::finalState(const Particle& particle,
-                                                      double zInteractionPoint,
-                                                      RandomNumberGenerator& rng) const {
-  return std::vector<Particle>();
+int PhotoDisintegration::getIsotopeIndex(PID pid) const {
+  const auto A = getPidNucleusMassNumber(pid);
+  const auto Z = getPidNucleusCharge(pid);
+  if (A < 0 || A > m_maxA || Z < 0 || Z > m_maxZ) return -1;
+  return m_isotopeIndex[A * (m_maxZ + 1) + Z];
+}
+
+void PhotoDisintegration::doCaching() {
+  const auto pids = m_xs->getPids();
+  m_maxA = 0;
+  m_maxZ = 0;
+  for (const auto& pid : pids) {
+    m_maxA = std::max(m_maxA, getPidNucleusMassNumber(pid));
+    m_maxZ = std::max(m_maxZ, getPidNucleusCharge(pid));
+  }
+  m_isotopeIndex.assign((m_maxA + 1) * (m_maxZ + 1), -1);
+  for (size_t k = 0; k < pids.size(); ++k) {
+    const auto A = getPidNucleusMassNumber(pids[k]);
+    const auto Z = getPidNucleusCharge(pids[k]);
+    m_isotopeIndex[A * (m_maxZ + 1) + Z] = (int)k;
+  }
+  LOGD << "caching photodisintegration rates for " << pids.size() << " isotopes";
+
+  // the Simpson nodes depend only on Gamma and I_gamma only on (eps', z), so both are shared
+  // by all the isotopes and channels of a table row
+  const auto nIsotopes = pids.size();
+  const auto dlnGamma =
+      (m_lnGammaRange.second - m_lnGammaRange.first) / (double)(m_lnGammaSize - 1);
+  const auto dz = (m_zRange.second - m_zRange.first) / (double)(m_zSize - 1);
+  const auto nBranchingBins = nIsotopes * m_branchingLnGammaSize * m_branchingZSize;
+  m_lnRates.assign(nIsotopes * m_lnGammaSize * m_zSize, std::log(minRate));
+  m_aliasProbability.assign(nBranchingBins * m_nChannels, 1.f);
+  m_alias.assign(nBranchingBins * m_nChannels, 0);
+  std::vector<double> epsPrime(simpsonIntervals + 1);
+  std::vector<double> sigma(m_nChannels * nIsotopes * (simpsonIntervals + 1));
+  std::vector<double> I(simpsonIntervals + 1);
+  double channelRates[m_nChannels];
+  for (size_t i = 0; i < m_lnGammaSize; ++i) {
+    const auto Gamma = std::exp(m_lnGammaRange.first + (double)i * dlnGamma);
+    const auto lnEpsPrimeRange = getLnEpsPrimeRange(Gamma);
+    const auto h = (lnEpsPrimeRange.second - lnEpsPrimeRange.first) / (double)simpsonIntervals;
+    for (size_t k = 0; k <= simpsonIntervals; ++k) {
+      epsPrime[k] = std::exp(lnEpsPrimeRange.first + (double)k * h);
+      const auto weight = (k == 0 || k == simpsonIntervals) ? 1. : ((k % 2 == 0) ? 2. : 4.);
+      for (size_t c = 0; c < m_nChannels; ++c)
+        for (size_t n = 0; n < nIsotopes; ++n)
+          sigma[(c * nIsotopes + n) * (simpsonIntervals + 1) + k] =
+              (h > 0.) ? weight * pow2(epsPrime[k]) * getChannelXsec(pids[n], epsPrime[k], c) : 0.;
+    }
+    const auto factor = h / 3. * SI::cLight / 2. / pow2(Gamma);
+    for (size_t j = 0; j < m_zSize; ++j) {
+      const auto z = m_zRange.first + (double)j * dz;
+      for (size_t k = 0; k <= simpsonIntervals; ++k)
+        I[k] = m_phField->I_gamma(epsPrime[k] / 2. / Gamma, z);
+      for (size_t n = 0; n < nIsotopes; ++n) {
+        double value = 0;
+        for (size_t c = 0; c < m_nChannels; ++c) {
+          const double* row = sigma.data() + (c * nIsotopes + n) * (simpsonIntervals + 1);
+          double channelValue = 0;
+          for (size_t k = 0; k <= simpsonIntervals; ++k) channelValue += row[k] * I[k];
+          channelRates[c] = std::max(factor * channelValue, 0.);
+          value += channelRates[c];
+        }
+        m_lnRates[(n * m_lnGammaSize + i) * m_zSize + j] = std::log(std::max(value, minRate));
+        if (i % m_branchingStride == 0 && j % m_branchingStride == 0) {
+          const auto bin = (n * m_branchingLnGammaSize + i / m_branchingStride) * m_branchingZSize +
+                           j / m_branchingStride;
+          utils::buildAliasTable(channelRates, m_nChannels, &m_aliasProbability[bin * m_nChannels],
+                                 &m_alias[bin * m_nChannels]);
+        }
+      }
+    }
+  }
+  m_doCaching = true;
+}
+
+double PhotoDisintegration::rate(PID pid, double Gamma, double z) const {
+  if (m_doCaching) {
+    const auto x = (std::log(Gamma) - m_lnGammaRange.first) /
+                   (m_lnGammaRange.second - m_lnGammaRange.first) * (double)(m_lnGammaSize - 1);
+    const auto y =
+        (z - m_zRange.first) / (m_zRange.second - m_zRange.first) * (double)(m_zSize - 1);
+    const auto index = getIsotopeIndex(pid);
+    if (index < 0) return 0;
+    if (x >= 0. && x <= (double)(m_lnGammaSize - 1) && y >= 0. && y <= (double)(m_zSize - 1)) {
+      const auto i = std::min((size_t)x, m_lnGammaSize - 2);
+      const auto j = std::min((size_t)y, m_zSize - 2);
+      const auto t = x - (double)i;
+      const auto s = y - (double)j;
+      const auto offset = ((size_t)index * m_lnGammaSize + i) * m_zSize + j;
+      const double* node = m_lnRates.data() + offset;
+      const auto lnRate = (1. - t) * ((1. - s) * node[0] + s * node[1]) +
+                          t * ((1. - s) * node[m_zSize] + s * node[m_zSize + 1]);
+      return (lnRate > std::log(minRate)) ? std::exp(lnRate) : 0.;
+    }
+  }
+  return computeRate(pid, Gamma, z);
+}
+
+size_t PhotoDisintegration::sampleChannel(double r, PID pid, double Gamma, double z) const {
+  const auto index = (m_doCaching) ? getIsotopeIndex(pid) : -1;
+  const auto x = (std::log(Gamma) - m_lnGammaRange.first) /
+                 (m_lnGammaRange.second - m_lnGammaRange.first) * (double)(m_lnGammaSize - 1);
+  const auto y =
+      (z - m_zRange.first) / (m_zRange.second - m_zRange.first) * (double)(m_zSize - 1);
+  if (index >= 0 && x >= 0. && x <= (double)(m_lnGammaSize - 1) && y >= 0. &&
+      y <= (double)(m_zSize - 1)) {
+    // branching ratios of the nearest node of the branching grid
+    const auto i = (size_t)(x / (double)m_branchingStride + 0.5);
+    const auto j = (size_t)(y / (double)m_branchingStride + 0.5);
+    const auto bin = ((size_t)index * m_branchingLnGammaSize + i) * m_branchingZSize + j;
+    return utils::sampleAliasTable(r, &m_aliasProbability[bin * m_nChannels],
+                                   &m_alias[bin * m_nChannels], m_nChannels);
+  }
+  double channelRates[m_nChannels];
+  double total = 0;
+  for (size_t c = 0; c < m_nChannels; ++c) {
+    channelRates[c] = computeChannelRate(pid, Gamma, z, c);
+    total += channelRates[c];
+  }
+  auto value = r * total;
+  for (size_t c = 0; c + 1 < m_nChannels; ++c) {
+    if (value < channelRates[c]) return c;
+    value -= channelRates[c];
+  }
+  return m_nChannels - 1;
+}
+
+void PhotoDisintegration::finalState(const Particle& particle, double zInteractionPoint,
+                                     RandomNumberGenerator& rng,
+                                     std::vector<Particle>& secondaries) const {
+  const auto pid = particle.getPid();
+  assert(pidIsNucleus(pid));
+  const auto w = particle.getWeight();
+  const auto Gamma = particle.getGamma();
+  const auto A = getPidNucleusMassNumber(pid);
+  const auto Z = getPidNucleusCharge(pid);
+
+  // the daughters keep the Lorentz factor of the parent nucleus
+  const auto channel = sampleChannel(rng(), pid, Gamma, zInteractionPoint);
+  if (channel == 0) {
+    const auto nucleon = (rng() < (double)Z / (double)A) ? proton : neutron;
+    if (A > 1) secondaries.emplace_back(removeNucleon(pid, nucleon), zInteractionPoint, Gamma, w);
+    secondaries.emplace_back(nucleon, zInteractionPoint, Gamma, w);
+  } else {
+    if (A > 4) secondaries.emplace_back(getPidNucleus(Z - 2, A - 4), zInteractionPoint, Gamma, w);
+    secondaries.emplace_back(He4, zInteractionPoint, Gamma, w);
+  }
 }
 
 }  // namespace interactions
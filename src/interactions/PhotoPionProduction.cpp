@@ -1,20 +1,31 @@
 #include "simprop/interactions/PhotoPionProduction.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
 #include "simprop/core/common.h"
+#include "simprop/energyLosses/PhotoPionContinuousLosses.h"
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
+#include "simprop/utils/registry.h"
 
 namespace simprop {
 namespace interactions {
 
 double PhotoPionProduction::sampleS(double r, PID nucleon, double sMax) const {
+  if (m_doReferenceSampling) return sampleSExact(r, nucleon, sMax);
   constexpr auto sThr = pow2(SI::protonMassC2 + SI::pionMassC2);
   if (sMax <= sThr) return 0;
-  auto rPhiMax = r * m_xs.getPhiAtS(nucleon, sMax);
-  return utils::rootFinder<double>([&](double s) { return m_xs.getPhiAtS(nucleon, s) - rPhiMax; },
+  const auto s = m_xs->getSAtPhi(nucleon, r * m_xs->getPhiAtS(nucleon, sMax));
+  return std::min(std::max(s, sThr), sMax);
+}
+
+double PhotoPionProduction::sampleSExact(double r, PID nucleon, double sMax) const {
+  constexpr auto sThr = pow2(SI::protonMassC2 + SI::pionMassC2);
+  if (sMax <= sThr) return 0;
+  auto rPhiMax = r * m_xs->getPhiAtS(nucleon, sMax);
+  return utils::rootFinder<double>([&](double s) { return m_xs->getPhiAtS(nucleon, s) - rPhiMax; },
                                    sThr, sMax, 1000, 1e-4);
 }
 
@@ -28,7 +39,7 @@ double PhotoPionProduction::epsPdfIntegral(double photonEnergy, PID nucleon, dou
                                            double z) const {
   auto integrand = [&](double eps) {
     const auto s_max = pow2(SI::protonMassC2) + 4. * nucleonEnergy * eps;
-    return m_phField->density(eps, z) / pow2(eps) * m_xs.getPhiAtS(nucleon, s_max);
+    return m_phField->density(eps, z) / pow2(eps) * m_xs->getPhiAtS(nucleon, s_max);
   };
   auto minPhEnergy = pickMinPhotonEnergy(m_phField->getMinPhotonEnergy(), nucleonEnergy);
   auto value = utils::QAGIntegration<double>(integrand, minPhEnergy, photonEnergy, 1000, 1e-3);
@@ -36,6 +47,16 @@ double PhotoPionProduction::epsPdfIntegral(double photonEnergy, PID nucleon, dou
 }
 
 double PhotoPionProduction::sampleEps(double r, PID nucleon, double nucleonEnergy, double z) const {
+  if (m_doCachingEps && !m_doReferenceSampling) {
+    const auto& table = (nucleon == proton) ? m_epsProtons : m_epsNeutrons;
+    const auto lnEnergy = std::log(nucleonEnergy);
+    if (table.xIsInside(lnEnergy) && table.yIsInside(z)) return std::exp(table.get(lnEnergy, z, r));
+  }
+  return sampleEpsExact(r, nucleon, nucleonEnergy, z);
+}
+
+double PhotoPionProduction::sampleEpsExact(double r, PID nucleon, double nucleonEnergy,
+                                           double z) const {
   auto minPhEnergy = pickMinPhotonEnergy(m_phField->getMinPhotonEnergy(), nucleonEnergy);
   auto maxPhotonEnergy = m_phField->getMaxPhotonEnergy();
   auto rIntegralMax = r * epsPdfIntegral(maxPhotonEnergy, nucleon, nucleonEnergy, z);
@@ -45,6 +66,43 @@ double PhotoPionProduction::sampleEps(double r, PID nucleon, double nucleonEnerg
   return value;
 }
 
+std::vector<double> PhotoPionProduction::computeEpsInverseCdf(PID nucleon, double nucleonEnergy,
+                                                              double z, size_t size) const {
+  // cumulative trapezoid of the eps pdf on a fine ln eps grid, inverted at equidistant u
+  const size_t nEps = 1000;
+  const auto lnEpsMin =
+      std::log(pickMinPhotonEnergy(m_phField->getMinPhotonEnergy(), nucleonEnergy));
+  const auto lnEpsMax = std::log(m_phField->getMaxPhotonEnergy());
+  std::vector<double> row(size, lnEpsMax);
+  if (!(lnEpsMax > lnEpsMin)) return row;
+
+  auto integrand = [&](double lnEps) {
+    const auto eps = std::exp(lnEps);
+    const auto s_max = pow2(SI::protonMassC2) + 4. * nucleonEnergy * eps;
+    return m_phField->density(eps, z) / eps * m_xs->getPhiAtS(nucleon, s_max);
+  };
+  const auto dlnEps = (lnEpsMax - lnEpsMin) / (double)(nEps - 1);
+  std::vector<double> cdf(nEps, 0.);
+  auto previous = integrand(lnEpsMin);
+  for (size_t k = 1; k < nEps; ++k) {
+    const auto current = integrand(lnEpsMin + (double)k * dlnEps);
+    cdf[k] = cdf[k - 1] + 0.5 * (previous + current) * dlnEps;
+    previous = current;
+  }
+  const auto total = cdf.back();
+  if (!(total > 0.)) return row;
+
+  size_t k = 0;
+  for (size_t j = 0; j < size; ++j) {
+    const auto target = total * (double)j / (double)(size - 1);
+    while (k + 2 < nEps && cdf[k + 1] < target) k++;
+    const auto dc = cdf[k + 1] - cdf[k];
+    const auto t = (dc > 0.) ? std::min(std::max((target - cdf[k]) / dc, 0.), 1.) : 0.;
+    row[j] = lnEpsMin + ((double)k + t) * dlnEps;
+  }
+  return row;
+}
+
 double samplePionInelasticity(double r, double s) {
   auto sqrt_s = std::sqrt(s);
   auto E_star = 0.5 * (s - pow2(SI::protonMassC2) + pow2(SI::pionMassC2)) / sqrt_s;
@@ -72,58 +130,130 @@ PID pickNucleon(double r, PID pid) {
 }
 
 PhotoPionProduction::PhotoPionProduction(const std::shared_ptr<photonfields::PhotonField>& phField)
-    : Interaction(phField) {
+    : Interaction(phField), m_xs(utils::DataRegistry::get<xsecs::PhotoPionXsec>()) {
   LOGD << "calling " << __func__ << " constructor";
 }
 
+std::pair<double, double> computeRateAndBeta(const xsecs::PhotoPionXsec& xs,
+                                             const photonfields::PhotonField& phField, PID pid,
+                                             double Gamma, double z) {
+  auto threshold = xs.getEpsPrimeThreshold();
+  auto lnEpsPrimeMin = std::log(std::max(threshold, 2. * Gamma * phField.getMinPhotonEnergy()));
+  auto lnEpsPrimeMax = std::log(2. * Gamma * phField.getMaxPhotonEnergy());
+  if (!(lnEpsPrimeMax > lnEpsPrimeMin)) return {0., 0.};
+  std::vector<double> epsPrime, eps, I, Y;
+  const auto values = utils::batchRombergIntegration<2>(
+      [&](const std::vector<double>& lnEpsPrime, std::array<std::vector<double>, 2>& y) {
+        const auto n = lnEpsPrime.size();
+        epsPrime.resize(n);
+        eps.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+          epsPrime[i] = std::exp(lnEpsPrime[i]);
+          eps[i] = epsPrime[i] / 2. / Gamma;
+        }
+        phField.batchIgamma(eps, z, I);
+        losses::inelasticity(epsPrime, Y);
+        for (size_t i = 0; i < n; ++i) {
+          y[0][i] = epsPrime[i] * epsPrime[i] * xs.getAtEpsPrime(pid, epsPrime[i]) * I[i];
+          y[1][i] = y[0][i] * Y[i];
+        }
+      },
+      lnEpsPrimeMin, lnEpsPrimeMax, 15, 1e-4);
+  const auto factor = SI::cLight / 2. / pow2(Gamma);
+  return {factor * std::max(values[0], 0.), factor * std::max(values[1], 0.)};
+}
+
 void PhotoPionProduction::doCaching() {
-  m_rateProtons.cacheTable(
+  m_isSelfSimilar = m_phField->isSelfSimilar();
+  if (m_isSelfSimilar) {
+    const Range lnScaledGammaRange = {std::log(1e7), std::log(1e14 * (1. + 10.))};
+    m_scaledRateProtons.cacheTables(
+        [this](double lnGamma) {
+          return computeRateAndBeta(*m_xs, *m_phField, proton, std::exp(lnGamma), 0.);
+        },
+        m_scaledBetaProtons, lnScaledGammaRange);
+    m_scaledRateNeutrons.cacheTables(
+        [this](double lnGamma) {
+          return computeRateAndBeta(*m_xs, *m_phField, neutron, std::exp(lnGamma), 0.);
+        },
+        m_scaledBetaNeutrons, lnScaledGammaRange);
+    m_doCaching = true;
+    return;
+  }
+  m_rateProtons.cacheTables(
       [this](double lnGamma, double z) {
-        auto Gamma = std::exp(lnGamma);
-        return computeNucleusRate(proton, Gamma, z);
+        return computeRateAndBeta(*m_xs, *m_phField, proton, std::exp(lnGamma), z);
       },
-      {std::log(1e7), std::log(1e14)}, {0., 10.});
-  m_rateNeutrons.cacheTable(
+      m_betaProtons, {std::log(1e7), std::log(1e14)}, {0., 10.});
+  m_rateNeutrons.cacheTables(
       [this](double lnGamma, double z) {
-        auto Gamma = std::exp(lnGamma);
-        return computeNucleusRate(neutron, Gamma, z);
+        return computeRateAndBeta(*m_xs, *m_phField, neutron, std::exp(lnGamma), z);
       },
-      {std::log(1e7), std::log(1e14)}, {0., 10.});
+      m_betaNeutrons, {std::log(1e7), std::log(1e14)}, {0., 10.});
   m_doCaching = true;
 }
 
-double PhotoPionProduction::computeNucleusRate(PID pid, double Gamma, double z, size_t N) const {
-  auto threshold = m_xs.getEpsPrimeThreshold();
-  auto lnEpsPrimeMin = std::log(std::max(threshold, 2. * Gamma * m_phField->getMinPhotonEnergy()));
-  auto lnEpsPrimeMax = std::log(2. * Gamma * m_phField->getMaxPhotonEnergy());
-  auto value = double(0);
-  if (lnEpsPrimeMax > lnEpsPrimeMin) {
-    value = utils::RombergIntegration<double>(
-        [&](double lnEpsPrime) {
-          auto epsPrime = std::exp(lnEpsPrime);
-          return epsPrime * epsPrime * m_xs.getAtEpsPrime(pid, epsPrime) *
-                 m_phField->I_gamma(epsPrime / 2. / Gamma, z);
-        },
-        lnEpsPrimeMin, lnEpsPrimeMax, N, 1e-4);
-    value *= SI::cLight / 2. / pow2(Gamma);
-  }
-  return std::max(value, 0.);
+void PhotoPionProduction::doCachingEps() {
+  const Range lnEnergyRange = {std::log(1e7 * SI::protonMassC2), std::log(1e14 * SI::protonMassC2)};
+  m_epsProtons.cacheTable(
+      [this](double lnEnergy, double z) {
+        return computeEpsInverseCdf(proton, std::exp(lnEnergy), z, 201);
+      },
+      lnEnergyRange, {0., 10.}, {0., 1.});
+  m_epsNeutrons.cacheTable(
+      [this](double lnEnergy, double z) {
+        return computeEpsInverseCdf(neutron, std::exp(lnEnergy), z, 201);
+      },
+      lnEnergyRange, {0., 10.}, {0., 1.});
+  m_doCachingEps = true;
 }
 
+// the rate is integrated together with the energy losses, so that cached and uncached rates come
+// from the same kernel and tolerance
+double PhotoPionProduction::computeNucleusRate(PID pid, double Gamma, double z) const {
+  return computeRateAndBeta(*m_xs, *m_phField, pid, Gamma, z).first;
+}
+
+// outside the tables the rate and the energy losses fall back to the integration
 double PhotoPionProduction::rate(PID pid, double Gamma, double z) const {
-  if (m_doCaching) {
+  const auto lnGamma = std::log(Gamma);
+  const auto lnScaledGamma = std::log(Gamma * (1. + z));
+  if (m_doCaching && m_isSelfSimilar && m_scaledRateProtons.xIsInside(lnScaledGamma)) {
     auto Z = getPidNucleusCharge(pid);
     auto A = getPidNucleusMassNumber(pid);
-    return Z * m_rateProtons.get(std::log(Gamma), z) +
-           (A - Z) * m_rateNeutrons.get(std::log(Gamma), z);
+    return pow3(1. + z) * (Z * m_scaledRateProtons.get(lnScaledGamma) +
+                           (A - Z) * m_scaledRateNeutrons.get(lnScaledGamma));
+  } else if (m_doCaching && !m_isSelfSimilar && m_rateProtons.xIsInside(lnGamma) &&
+             m_rateProtons.yIsInside(z)) {
+    auto Z = getPidNucleusCharge(pid);
+    auto A = getPidNucleusMassNumber(pid);
+    return Z * m_rateProtons.get(lnGamma, z) + (A - Z) * m_rateNeutrons.get(lnGamma, z);
   } else {
     return computeNucleusRate(pid, Gamma, z);
   }
 }
 
-std::vector<Particle> PhotoPionProduction::finalState(const Particle& incomingParticle,
-                                                      double zInteractionPoint,
-                                                      RandomNumberGenerator& rng) const {
+double PhotoPionProduction::beta(PID pid, double Gamma, double z) const {
+  const auto lnGamma = std::log(Gamma);
+  const auto lnScaledGamma = std::log(Gamma * (1. + z));
+  if (m_doCaching && m_isSelfSimilar && m_scaledBetaProtons.xIsInside(lnScaledGamma)) {
+    auto Z = getPidNucleusCharge(pid);
+    auto A = getPidNucleusMassNumber(pid);
+    return pow3(1. + z) * (Z * m_scaledBetaProtons.get(lnScaledGamma) +
+                           (A - Z) * m_scaledBetaNeutrons.get(lnScaledGamma));
+  } else if (m_doCaching && !m_isSelfSimilar && m_betaProtons.xIsInside(lnGamma) &&
+             m_betaProtons.yIsInside(z)) {
+    auto Z = getPidNucleusCharge(pid);
+    auto A = getPidNucleusMassNumber(pid);
+    return Z * m_betaProtons.get(lnGamma, z) + (A - Z) * m_betaNeutrons.get(lnGamma, z);
+  } else {
+    return computeRateAndBeta(*m_xs, *m_phField, pid, Gamma, z).second;
+  }
+}
+
+void PhotoPionProduction::finalState(const Particle& incomingParticle, double zInteractionPoint,
+                                     RandomNumberGenerator& rng,
+                                     std::vector<Particle>& secondaries) const {
   const auto pid = incomingParticle.getPid();
   assert(pidIsNucleus(pid));
   const auto w = incomingParticle.getWeight();
@@ -141,15 +271,10 @@ std::vector<Particle> PhotoPionProduction::finalState(const Particle& incomingPa
 
   const auto outNucleonEnergy = nucleonEnergy - outPionEnergy;
 
-  auto outPion = Particle(outPionCharge, zInteractionPoint, outPionEnergy / SI::pionMassC2, w);
-  auto outNucleon = Particle(proton, zInteractionPoint, outNucleonEnergy / SI::protonMassC2, w);
-
-  if (pidIsNucleon(pid)) {
-    return {outNucleon, outPion};
-  } else {
-    auto outNuclues = Particle(removeNucleon(pid, nucleon), zInteractionPoint, Gamma, w);
-    return {outNuclues, outNucleon, outPion};
-  }
+  if (!pidIsNucleon(pid))
+    secondaries.emplace_back(removeNucleon(pid, nucleon), zInteractionPoint, Gamma, w);
+  secondaries.emplace_back(proton, zInteractionPoint, outNucleonEnergy / SI::protonMassC2, w);
+  secondaries.emplace_back(outPionCharge, zInteractionPoint, outPionEnergy / SI::pionMassC2, w);
 }
 
 }  // namespace interactions
@@ -1,5 +1,11 @@
 #include "simprop/interactions/PhotoPionProductionSophia.h"
 
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
 #include "simprop/utils/logging.h"
 #include "sophia_interface.h"
 
@@ -61,9 +67,106 @@ PID ID_sophia_to_SimProp(int sophiaID) {
   }
 }
 
-std::vector<Particle> PhotoPionProductionSophia::finalState(const Particle& incomingParticle,
-                                                            double zInteractionPoint,
-                                                            RandomNumberGenerator& rng) const {
+namespace {
+
+// SOPHIA keeps its state in global common blocks, calls from the same process are serialized
+std::mutex sophiaMutex;
+
+const bool declareChargedPionsStable = true;
+
+// the settings stored with a generated event library and checked when it is loaded
+const std::string libraryGenerator =
+    std::string("SOPHIA chargedPionsStable=") + (declareChargedPionsStable ? "1" : "0");
+
+Range librarySqrtsRange() { return {SI::protonMassC2 + SI::pionMassC2, 1.9e3 * SI::GeV}; }
+
+// the generator is reseeded under the lock, so that the event depends on the seed only and not
+// on the order in which the threads take the lock
+sophiaevent_output callSophia(bool onProton, double Ein, double eps, uint64_t seed) {
+  std::lock_guard<std::mutex> lock(sophiaMutex);
+  seedSophia(seed);
+  sophia_interface SI;
+  return SI.sophiaevent(onProton, Ein, eps, declareChargedPionsStable);
+}
+
+}  // namespace
+
+std::shared_ptr<SophiaEventLibrary> PhotoPionProductionSophia::generateEventLibrary(
+    size_t nBins, size_t eventsPerBin) {
+  auto library = std::make_shared<SophiaEventLibrary>(librarySqrtsRange(), nBins, eventsPerBin,
+                                                      libraryGenerator);
+  const auto maxAttempts = 20 * eventsPerBin;
+  size_t nRejected = 0;
+  // the events are seeded by their index, so that a library is reproduced by its parameters
+  uint64_t nEvents = 0;
+  for (auto nucleon : {proton, neutron}) {
+    const bool onProton = (nucleon == proton);
+    const double mass = (onProton) ? 0.93827 : 0.93957;  // SOPHIA nucleon masses in GeV
+    // each bin is filled with events generated at the largest s of the bin, the sampled
+    // collision angle drops some of them in the lower bins
+    for (size_t iBin = nBins; iBin-- > 0;) {
+      const auto sqrtsHigh = library->getBinUpperEdge(iBin) / SI::GeV;
+      const auto Ein = std::max(10., sqrtsHigh);
+      const auto pin = std::sqrt(pow2(Ein) - pow2(mass));
+      const auto eps = (pow2(sqrtsHigh) - pow2(mass)) / (2. * (Ein + pin));
+      for (size_t i = 0; i < maxAttempts && !library->isFull(nucleon, iBin); ++i) {
+        const auto seo = callSophia(onProton, Ein, eps, nEvents++);
+        double P[4] = {0, 0, 0, 0};
+        for (int j = 0; j < seo.Nout; ++j)
+          for (int k = 0; k < 4; ++k) P[k] += seo.outPartP[k][j];
+        // the photon four-momentum is what is left after removing the nucleon moving along z,
+        // the sign of its momentum is the one leaving a massless photon
+        double photon[2][4];
+        double photonMass2[2];
+        for (int sign = 0; sign < 2; ++sign) {
+          const double pz = (sign == 0) ? pin : -pin;
+          double* k = photon[sign];
+          k[0] = P[0];
+          k[1] = P[1];
+          k[2] = P[2] - pz;
+          k[3] = P[3] - Ein;
+          photonMass2[sign] = std::fabs(pow2(k[3]) - pow2(k[0]) - pow2(k[1]) - pow2(k[2]));
+        }
+        const double* k = photon[(photonMass2[0] < photonMass2[1]) ? 0 : 1];
+        if (std::min(photonMass2[0], photonMass2[1]) > 1e-6 * pow2(k[3])) {
+          nRejected++;
+          continue;
+        }
+        // light-cone fractions along the photon, invariant under boosts of the nucleon
+        const auto Pk = P[3] * k[3] - P[0] * k[0] - P[1] * k[1] - P[2] * k[2];
+        std::vector<SophiaEventLibrary::Secondary> secondaries;
+        for (int j = 0; j < seo.Nout; ++j) {
+          const auto pk = seo.outPartP[3][j] * k[3] - seo.outPartP[0][j] * k[0] -
+                          seo.outPartP[1][j] * k[1] - seo.outPartP[2][j] * k[2];
+          secondaries.push_back({ID_sophia_to_SimProp(seo.outPartID[j]), pk / Pk});
+        }
+        const auto sqrts = std::sqrt(pow2(P[3]) - pow2(P[0]) - pow2(P[1]) - pow2(P[2]));
+        library->add(nucleon, sqrts * SI::GeV, secondaries);
+      }
+      if (!library->isFull(nucleon, iBin)) {
+        LOGW << "event library bin " << iBin << " for " << getPidName(nucleon) << " has "
+             << library->getEventsSize(nucleon, iBin) << " events";
+      }
+    }
+  }
+  if (nRejected > 0) {
+    LOGW << nRejected << " SOPHIA events with unexpected kinematics rejected";
+  }
+  return library;
+}
+
+std::shared_ptr<SophiaEventLibrary> PhotoPionProductionSophia::loadEventLibrary(
+    const std::string& filename, size_t nBins, size_t eventsPerBin) {
+  auto library = std::make_shared<SophiaEventLibrary>(SophiaEventLibrary::load(filename));
+  if (!library->hasParameters(librarySqrtsRange(), nBins, eventsPerBin, libraryGenerator))
+    throw std::runtime_error("event library " + filename +
+                             " was generated with other parameters, remove it to regenerate");
+  return library;
+}
+
+void PhotoPionProductionSophia::finalState(const Particle& incomingParticle,
+                                           double zInteractionPoint, RandomNumberGenerator& rng,
+                                           std::vector<Particle>& secondaries) const {
   const auto pid = incomingParticle.getPid();
   assert(pidIsNucleus(pid));
   const auto w = incomingParticle.getWeight();
@@ -73,27 +176,37 @@ std::vector<Particle> PhotoPionProductionSophia::finalState(const Particle& inco
   const auto nucleonEnergy = Gamma * SI::protonMassC2;
   const auto photonEnergy = sampleEps(rng(), nucleon, nucleonEnergy, zInteractionPoint);
 
+  if (m_library) {
+    const auto sMax = pow2(SI::protonMassC2) + 4. * nucleonEnergy * photonEnergy;
+    const auto sqrts = std::sqrt(sampleS(rng(), nucleon, sMax));
+    const auto totalEnergy = nucleonEnergy + photonEnergy;
+    if (m_library->sample(rng(), nucleon, sqrts, totalEnergy, zInteractionPoint, w, secondaries))
+      return;
+  }
+
   const bool onProton = (nucleon == proton);
   const double Ein = nucleonEnergy / SI::GeV;
   const double eps = photonEnergy / SI::GeV;
-  const bool declareChargedPionsStable = true;
-
-  sophia_interface SI;
-  sophiaevent_output seo = SI.sophiaevent(onProton, Ein, eps, declareChargedPionsStable);
+  // the event is run from a seed drawn from the caller stream, so that it is reproduced by the
+  // per-primary streams whichever thread or worker runs it
+  const auto seed = static_cast<uint64_t>(rng() * 9007199254740992.);
+  sophiaevent_output seo;
+  if (m_workers)
+    m_workers->event(onProton, Ein, eps, seed, seo);
+  else
+    seo = callSophia(onProton, Ein, eps, seed);
 
-  std::vector<Particle> outgoingParticle;
   int Nout = seo.Nout;
   for (int i = 0; i < Nout; ++i) {
     PID pid = ID_sophia_to_SimProp(seo.outPartID[i]);
     auto mass = getPidMass(pid);
     auto E = seo.outPartP[3][i] * SI::GeV;
     if (mass > 0.) {
-      outgoingParticle.push_back({pid, zInteractionPoint, E / mass, w});
+      secondaries.emplace_back(pid, zInteractionPoint, E / mass, w);
     } else {
-      outgoingParticle.push_back({pid, zInteractionPoint, E, w});  // TODO terrible patch :(
+      secondaries.emplace_back(pid, zInteractionPoint, E, w);  // TODO terrible patch :(
     }
   }
-  return outgoingParticle;
 }
 
 }  // namespace interactions
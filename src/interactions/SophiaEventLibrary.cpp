@@ -0,0 +1,173 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/interactions/SophiaEventLibrary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include "simprop/core/units.h"
+#include "simprop/utils/io.h"
+#include "simprop/utils/logging.h"
+
+namespace simprop {
+namespace interactions {
+
+namespace {
+
+const uint64_t libraryMagic = 0x53505053454c3032;  // "SPPSEL02"
+
+size_t getNucleonIndex(PID nucleon) {
+  if (nucleon == proton) return 0;
+  if (nucleon == neutron) return 1;
+  throw std::invalid_argument("event library is defined for nucleons only");
+}
+
+}  // namespace
+
+SophiaEventLibrary::SophiaEventLibrary(Range sqrtsRange, size_t nBins, size_t eventsPerBin,
+                                       const std::string& generator)
+    : m_lnSqrtsMin(std::log(sqrtsRange.first)),
+      m_lnSqrtsMax(std::log(sqrtsRange.second)),
+      m_nBins(nBins),
+      m_eventsPerBin(eventsPerBin),
+      m_generator(generator),
+      m_bins(2 * nBins) {
+  if (!(sqrtsRange.first > 0.) || !(sqrtsRange.second > sqrtsRange.first))
+    throw std::invalid_argument("event library range must satisfy 0 < min < max");
+  if (nBins < 1 || eventsPerBin < 1)
+    throw std::invalid_argument("event library needs at least one bin and one event per bin");
+}
+
+bool SophiaEventLibrary::hasParameters(Range sqrtsRange, size_t nBins, size_t eventsPerBin,
+                                       const std::string& generator) const {
+  // the range goes through a GeV conversion in the file, it is compared to rounding
+  const auto isClose = [](double a, double b) { return std::fabs(a - b) < 1e-9; };
+  return isClose(m_lnSqrtsMin, std::log(sqrtsRange.first)) &&
+         isClose(m_lnSqrtsMax, std::log(sqrtsRange.second)) && m_nBins == nBins &&
+         m_eventsPerBin == eventsPerBin && m_generator == generator;
+}
+
+bool SophiaEventLibrary::isInside(double sqrts) const {
+  const auto lnSqrts = std::log(sqrts);
+  return lnSqrts >= m_lnSqrtsMin && lnSqrts < m_lnSqrtsMax;
+}
+
+size_t SophiaEventLibrary::findBin(double sqrts) const {
+  const auto x = (std::log(sqrts) - m_lnSqrtsMin) / (m_lnSqrtsMax - m_lnSqrtsMin);
+  return std::min((size_t)std::max(x * (double)m_nBins, 0.), m_nBins - 1);
+}
+
+double SophiaEventLibrary::getBinUpperEdge(size_t iBin) const {
+  const auto t = (double)(iBin + 1) / (double)m_nBins;
+  return std::exp(m_lnSqrtsMin + t * (m_lnSqrtsMax - m_lnSqrtsMin));
+}
+
+const SophiaEventLibrary::Bin& SophiaEventLibrary::getBin(PID nucleon, size_t iBin) const {
+  return m_bins.at(getNucleonIndex(nucleon) * m_nBins + iBin);
+}
+
+SophiaEventLibrary::Bin& SophiaEventLibrary::getBin(PID nucleon, size_t iBin) {
+  return m_bins.at(getNucleonIndex(nucleon) * m_nBins + iBin);
+}
+
+size_t SophiaEventLibrary::getEventsSize(PID nucleon, size_t iBin) const {
+  return getBin(nucleon, iBin).offsets.size() - 1;
+}
+
+bool SophiaEventLibrary::isFull(PID nucleon, size_t iBin) const {
+  return getEventsSize(nucleon, iBin) >= m_eventsPerBin;
+}
+
+uint8_t SophiaEventLibrary::getSpeciesIndex(PID pid) {
+  auto it = std::find(m_species.begin(), m_species.end(), pid);
+  if (it != m_species.end()) return (uint8_t)(it - m_species.begin());
+  if (m_species.size() >= 256) throw std::runtime_error("too many species in event library");
+  m_species.push_back(pid);
+  return (uint8_t)(m_species.size() - 1);
+}
+
+bool SophiaEventLibrary::add(PID nucleon, double sqrts, const std::vector<Secondary>& secondaries) {
+  if (!isInside(sqrts)) return false;
+  const auto iBin = findBin(sqrts);
+  if (isFull(nucleon, iBin)) return false;
+  auto& bin = getBin(nucleon, iBin);
+  for (const auto& secondary : secondaries) {
+    bin.species.push_back(getSpeciesIndex(secondary.first));
+    bin.fractions.push_back((float)secondary.second);
+  }
+  bin.offsets.push_back((uint32_t)bin.species.size());
+  return true;
+}
+
+bool SophiaEventLibrary::sample(double r, PID nucleon, double sqrts, double totalEnergy, double z,
+                                double weight, std::vector<Particle>& particles) const {
+  if (!isInside(sqrts)) return false;
+  const auto& bin = getBin(nucleon, findBin(sqrts));
+  const auto nEvents = bin.offsets.size() - 1;
+  if (nEvents == 0) return false;
+  const auto iEvent = std::min((size_t)(r * (double)nEvents), nEvents - 1);
+  for (auto i = bin.offsets[iEvent]; i < bin.offsets[iEvent + 1]; ++i) {
+    const auto pid = m_species[bin.species[i]];
+    const auto mass = getPidMass(pid);
+    const auto E = (double)bin.fractions[i] * totalEnergy;
+    particles.emplace_back(pid, z, (mass > 0.) ? E / mass : E, weight);
+  }
+  return true;
+}
+
+void SophiaEventLibrary::save(const std::string& filename) const {
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  if (!out) throw std::runtime_error("cannot open event library file " + filename);
+  utils::writeBinary(out, libraryMagic);
+  utils::writeBinary(out, std::exp(m_lnSqrtsMin) / SI::GeV);
+  utils::writeBinary(out, std::exp(m_lnSqrtsMax) / SI::GeV);
+  utils::writeBinary<uint64_t>(out, m_nBins);
+  utils::writeBinary<uint64_t>(out, m_eventsPerBin);
+  utils::writeBinaryString(out, m_generator);
+  utils::writeBinary<uint64_t>(out, m_species.size());
+  for (const auto& pid : m_species) utils::writeBinary<int64_t>(out, pid.get());
+  for (const auto& bin : m_bins) {
+    utils::writeBinary<uint64_t>(out, bin.offsets.size());
+    out.write(reinterpret_cast<const char*>(bin.offsets.data()),
+              bin.offsets.size() * sizeof(uint32_t));
+    utils::writeBinary<uint64_t>(out, bin.species.size());
+    out.write(reinterpret_cast<const char*>(bin.species.data()), bin.species.size());
+    out.write(reinterpret_cast<const char*>(bin.fractions.data()),
+              bin.fractions.size() * sizeof(float));
+  }
+  if (!out) throw std::runtime_error("failed writing event library file " + filename);
+  LOGD << "event library written to " << filename;
+}
+
+SophiaEventLibrary SophiaEventLibrary::load(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) throw std::runtime_error("cannot open event library file " + filename);
+  if (utils::readBinary<uint64_t>(in) != libraryMagic)
+    throw std::runtime_error(filename + " is not an event library file of the current format");
+  const auto sqrtsMin = utils::readBinary<double>(in) * SI::GeV;
+  const auto sqrtsMax = utils::readBinary<double>(in) * SI::GeV;
+  const auto nBins = utils::readBinary<uint64_t>(in);
+  const auto eventsPerBin = utils::readBinary<uint64_t>(in);
+  const auto generator = utils::readBinaryString(in);
+  SophiaEventLibrary library({sqrtsMin, sqrtsMax}, nBins, eventsPerBin, generator);
+  const auto nSpecies = utils::readBinary<uint64_t>(in);
+  for (uint64_t i = 0; i < nSpecies; ++i)
+    library.m_species.push_back(PID(utils::readBinary<int64_t>(in)));
+  for (auto& bin : library.m_bins) {
+    bin.offsets.resize(utils::readBinary<uint64_t>(in));
+    in.read(reinterpret_cast<char*>(bin.offsets.data()), bin.offsets.size() * sizeof(uint32_t));
+    const auto size = utils::readBinary<uint64_t>(in);
+    bin.species.resize(size);
+    bin.fractions.resize(size);
+    in.read(reinterpret_cast<char*>(bin.species.data()), size);
+    in.read(reinterpret_cast<char*>(bin.fractions.data()), size * sizeof(float));
+    if (!in || bin.offsets.empty() || bin.offsets.back() != size)
+      throw std::runtime_error("corrupted event library file " + filename);
+  }
+  LOGD << "event library loaded from " << filename;
+  return library;
+}
+
+}  // namespace interactions
+}  // namespace simprop
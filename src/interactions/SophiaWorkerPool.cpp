@@ -0,0 +1,202 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/interactions/SophiaWorkerPool.h"
+
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+
+#include "simprop/utils/logging.h"
+#include "sophia_interface.h"
+
+namespace simprop {
+namespace interactions {
+
+namespace {
+
+struct Request {
+  int32_t onProton;
+  double Ein;
+  double eps;
+  uint64_t seed;
+};
+
+bool writeAll(int fd, const void* buffer, size_t size) {
+  auto data = static_cast<const char*>(buffer);
+  while (size > 0) {
+    const auto n = write(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+// blocks SIGPIPE on the calling thread only, a write to a dead worker is then reported by the
+// write itself and its signal is discarded before the mask is restored, so that the signal
+// handling of the host process is left untouched
+class SigpipeBlock {
+ public:
+  SigpipeBlock() {
+    sigemptyset(&m_pipe);
+    sigaddset(&m_pipe, SIGPIPE);
+    sigset_t pending;
+    sigpending(&pending);
+    m_wasPending = (sigismember(&pending, SIGPIPE) == 1);
+    pthread_sigmask(SIG_BLOCK, &m_pipe, &m_previous);
+  }
+  ~SigpipeBlock() {
+    if (!m_wasPending) {
+      const timespec noWait = {0, 0};
+      while (sigtimedwait(&m_pipe, nullptr, &noWait) == SIGPIPE) {
+      }
+    }
+    pthread_sigmask(SIG_SETMASK, &m_previous, nullptr);
+  }
+
+ private:
+  sigset_t m_pipe;
+  sigset_t m_previous;
+  bool m_wasPending;
+};
+
+bool readAll(int fd, void* buffer, size_t size) {
+  auto data = static_cast<char*>(buffer);
+  while (size > 0) {
+    const auto n = read(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+}  // namespace
+
+void seedSophia(uint64_t seed) {
+  std::srand((unsigned)(seed ^ (seed >> 32)));
+  unsigned short state[3] = {(unsigned short)seed, (unsigned short)(seed >> 16),
+                             (unsigned short)(seed >> 32)};
+  seed48(state);
+}
+
+SophiaWorkerPool::SophiaWorkerPool(size_t nWorkers, WorkerInit workerInit) {
+  LOGD << "calling " << __func__ << " constructor";
+  if (nWorkers < 1) throw std::invalid_argument("SOPHIA pool needs at least one worker");
+  for (size_t i = 0; i < nWorkers; ++i) {
+    int request[2], response[2];
+    if (pipe(request) != 0) {
+      stop();
+      throw std::runtime_error("cannot create pipes for SOPHIA workers");
+    }
+    if (pipe(response) != 0) {
+      close(request[0]);
+      close(request[1]);
+      stop();
+      throw std::runtime_error("cannot create pipes for SOPHIA workers");
+    }
+    const auto pid = fork();
+    if (pid < 0) {
+      for (auto fd : {request[0], request[1], response[0], response[1]}) close(fd);
+      stop();
+      throw std::runtime_error("cannot fork SOPHIA worker");
+    }
+    if (pid == 0) {
+      close(request[1]);
+      close(response[0]);
+      for (const auto& worker : m_workers) {
+        close(worker.requestFd);
+        close(worker.responseFd);
+      }
+      if (workerInit) workerInit(i);
+      serve(request[0], response[1]);
+      _exit(0);
+    }
+    close(request[0]);
+    close(response[1]);
+    m_workers.push_back({pid, request[1], response[0]});
+    m_idle.push_back(i);
+  }
+  LOGD << "started " << nWorkers << " SOPHIA workers";
+}
+
+SophiaWorkerPool::~SophiaWorkerPool() { stop(); }
+
+void SophiaWorkerPool::stop() {
+  // closing the request pipe ends the worker loop
+  for (const auto& worker : m_workers) {
+    close(worker.requestFd);
+    close(worker.responseFd);
+  }
+  for (const auto& worker : m_workers) waitpid(worker.pid, nullptr, 0);
+  m_workers.clear();
+  m_idle.clear();
+}
+
+void SophiaWorkerPool::serve(int requestFd, int responseFd) {
+  Request request;
+  while (readAll(requestFd, &request, sizeof(Request))) {
+    seedSophia(request.seed);
+    sophia_interface SI;
+    const auto seo = SI.sophiaevent(request.onProton != 0, request.Ein, request.eps, true);
+    const int32_t Nout = seo.Nout;
+    bool ok = writeAll(responseFd, &Nout, sizeof(Nout));
+    ok = ok && writeAll(responseFd, seo.outPartID, Nout * sizeof(seo.outPartID[0]));
+    for (int k = 0; k < 5; ++k)
+      ok = ok && writeAll(responseFd, seo.outPartP[k], Nout * sizeof(seo.outPartP[k][0]));
+    if (!ok) break;
+  }
+}
+
+void SophiaWorkerPool::event(bool onProton, double Ein, double eps, uint64_t seed,
+                             sophiaevent_output& output) {
+  size_t iWorker;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this] { return !m_idle.empty(); });
+    iWorker = m_idle.back();
+    m_idle.pop_back();
+  }
+  const auto ok = event(iWorker, onProton, Ein, eps, seed, output);
+  // a failed worker goes back to the queue as well, so that later calls fail instead of waiting
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(iWorker);
+  }
+  m_idleCondition.notify_one();
+  if (!ok)
+    throw std::runtime_error("SOPHIA worker " + std::to_string(m_workers[iWorker].pid) + " failed");
+}
+
+bool SophiaWorkerPool::event(size_t iWorker, bool onProton, double Ein, double eps, uint64_t seed,
+                             sophiaevent_output& output) {
+  const auto& worker = m_workers.at(iWorker);
+  const Request request = {onProton ? 1 : 0, Ein, eps, seed};
+  int32_t Nout = 0;
+  bool ok;
+  {
+    // a worker that died is reported by the failing write, not by SIGPIPE
+    SigpipeBlock block;
+    ok = writeAll(worker.requestFd, &request, sizeof(Request));
+  }
+  ok = ok && readAll(worker.responseFd, &Nout, sizeof(Nout));
+  const auto maxNout = (int32_t)(sizeof(output.outPartID) / sizeof(output.outPartID[0]));
+  ok = ok && Nout >= 0 && Nout <= maxNout;
+  ok = ok && readAll(worker.responseFd, output.outPartID, Nout * sizeof(output.outPartID[0]));
+  for (int k = 0; k < 5; ++k)
+    ok = ok && readAll(worker.responseFd, output.outPartP[k], Nout * sizeof(output.outPartP[k][0]));
+  if (ok) output.Nout = Nout;
+  return ok;
+}
+
+}  // namespace interactions
+}  // namespace simprop
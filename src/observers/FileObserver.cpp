@@ -0,0 +1,35 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/observers/FileObserver.h"
+
+#include <sstream>
+
+namespace simprop {
+namespace observers {
+
+FileObserver::FileObserver(const std::string& filename)
+    : FileObserver(filename, [](const Particle& particle) {
+        std::ostringstream line;
+        line << particle;
+        return line.str();
+      }) {}
+
+FileObserver::FileObserver(const std::string& filename, Formatter formatter)
+    : m_out(filename), m_formatter(formatter) {}
+
+void FileObserver::observe(const Particle& particle) {
+  m_out << m_formatter(particle) << "\n";
+  m_counter++;
+}
+
+void FileObserver::save(std::ostream& out) {
+  utils::writeBinary<uint64_t>(out, m_counter);
+  utils::writeBinary<uint64_t>(out, m_out.sync());
+}
+
+void FileObserver::load(std::istream& in) {
+  m_counter = utils::readBinary<uint64_t>(in);
+  m_out.truncate(utils::readBinary<uint64_t>(in));
+}
+
+}  // namespace observers
+}  // namespace simprop
@@ -0,0 +1,16 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/observers/FilterObserver.h"
+
+#include <algorithm>
+
+namespace simprop {
+namespace observers {
+
+FilterObserver::Condition IsSpecies(const std::vector<PID>& species) {
+  return [species](const Particle& particle) {
+    return std::find(species.begin(), species.end(), particle.getPid()) != species.end();
+  };
+}
+
+}  // namespace observers
+}  // namespace simprop
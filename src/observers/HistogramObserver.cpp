@@ -0,0 +1,52 @@
+// Copyright 2023 SimProp-dev [MIT License]
+#include "simprop/observers/HistogramObserver.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "simprop/utils/io.h"
+
+namespace simprop {
+namespace observers {
+
+HistogramObserver::HistogramObserver(Range energyRange, size_t nBins)
+    : m_energyAxis(nBins), m_counts(nBins, 0.) {
+  if (nBins == 0 || !(energyRange.first > 0.) || !(energyRange.second > energyRange.first))
+    throw std::invalid_argument("invalid histogram binning");
+  m_lnEnergyMin = std::log(energyRange.first);
+  m_dlnEnergy = (std::log(energyRange.second) - m_lnEnergyMin) / (double)nBins;
+  for (size_t i = 0; i < nBins; ++i)
+    m_energyAxis[i] = std::exp(m_lnEnergyMin + ((double)i + 0.5) * m_dlnEnergy);
+}
+
+void HistogramObserver::observe(const Particle& particle) {
+  const auto x = (std::log(particle.getEnergy()) - m_lnEnergyMin) / m_dlnEnergy;
+  if (x < 0.)
+    m_underflow += particle.getWeight();
+  else if (x >= (double)m_counts.size())
+    m_overflow += particle.getWeight();
+  else
+    m_counts[(size_t)x] += particle.getWeight();
+}
+
+void HistogramObserver::save(std::ostream& out) {
+  for (const auto& count : m_counts) utils::writeBinary(out, count);
+  utils::writeBinary(out, m_underflow);
+  utils::writeBinary(out, m_overflow);
+}
+
+void HistogramObserver::load(std::istream& in) {
+  for (auto& count : m_counts) count = utils::readBinary<double>(in);
+  m_underflow = utils::readBinary<double>(in);
+  m_overflow = utils::readBinary<double>(in);
+}
+
+void HistogramObserver::dump(const std::string& filename) const {
+  utils::OutputFile out(filename);
+  out << "# E [eV] - counts\n";
+  for (size_t i = 0; i < m_counts.size(); ++i)
+    out << m_energyAxis[i] / SI::eV << " " << m_counts[i] << "\n";
+}
+
+}  // namespace observers
+}  // namespace simprop
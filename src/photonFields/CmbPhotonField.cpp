@@ -24,9 +24,41 @@ double CMB::I_gamma(double epsRestFrame, double z) const {
   if (epsRestFrame < m_epsRange.first || epsRestFrame > m_epsRange.second) return 0;
   constexpr double factor = 1. / pow2(M_PI) / pow3(SI::hbarC);
   const auto kT = SI::kBoltzmann * m_temperature * (1. + z);
-  const auto I = factor * kT * (-std::log(1. - std::exp(-epsRestFrame / kT)));
+  const auto I = factor * kT * (-std::log1p(-std::exp(-epsRestFrame / kT)));
   return std::fabs(I);
 }
 
+// the Planck kernels are evaluated on all the energies and masked outside the range, so that the
+// loops have no branches
+void CMB::batchDensity(const std::vector<double>& epsRestFrame, double z,
+                       std::vector<double>& values) const {
+  constexpr double factor = 1. / pow2(M_PI) / pow3(SI::hbarC);
+  const auto n = epsRestFrame.size();
+  values.resize(n);
+  const double* eps = epsRestFrame.data();
+  double* v = values.data();
+  const auto kT = SI::kBoltzmann * m_temperature * (1. + z);
+  const auto lo = m_epsRange.first, hi = m_epsRange.second;
+  for (size_t i = 0; i < n; ++i) {
+    const auto density = factor * pow2(eps[i]) / std::expm1(eps[i] / kT);
+    v[i] = (eps[i] >= lo && eps[i] <= hi) ? std::max(density, 0.) : 0.;
+  }
+}
+
+void CMB::batchIgamma(const std::vector<double>& epsRestFrame, double z,
+                      std::vector<double>& values) const {
+  constexpr double factor = 1. / pow2(M_PI) / pow3(SI::hbarC);
+  const auto n = epsRestFrame.size();
+  values.resize(n);
+  const double* eps = epsRestFrame.data();
+  double* v = values.data();
+  const auto kT = SI::kBoltzmann * m_temperature * (1. + z);
+  const auto lo = m_epsRange.first, hi = m_epsRange.second;
+  for (size_t i = 0; i < n; ++i) {
+    const auto I = factor * kT * (-std::log1p(-std::exp(-eps[i] / kT)));
+    v[i] = (eps[i] >= lo && eps[i] <= hi) ? std::fabs(I) : 0.;
+  }
+}
+
 }  // namespace photonfields
 }  // namespace simprop
@@ -5,6 +5,7 @@
 #include "simprop/utils/io.h"
 #include "simprop/utils/logging.h"
 #include "simprop/utils/numeric.h"
+#include "simprop/utils/registry.h"
 
 namespace simprop {
 namespace photonfields {
@@ -13,22 +14,23 @@ LookupTablePhotonField::LookupTablePhotonField(size_t zSize, size_t eSize, std::
   m_zSize = zSize;
   m_eSize = eSize;
   m_filename = "data/" + filename;
-  auto fileSize = utils::countFileLines(m_filename);
-  if (utils::fileExists(m_filename) && fileSize == (zSize * eSize)) {
-    m_redshifts.reserve(zSize);
-    m_logPhotonEnergies.reserve(eSize);
-    m_logDensity.reserve(zSize * eSize);
-    m_logIgamma.reserve(zSize * eSize);
-    loadDataFile();
-  } else {
+  m_table = utils::DataRegistry::get<Table>(m_filename, [this]() { return loadDataFile(); });
+  if (m_table->redshifts.size() != zSize || m_table->logPhotonEnergies.size() != eSize)
     throw std::runtime_error("error reading from file : " + filename);
-  }
   LOGD << "calling " << __func__ << " constructor";
 }
 
-void LookupTablePhotonField::loadDataFile() {
+std::shared_ptr<const LookupTablePhotonField::Table> LookupTablePhotonField::loadDataFile() const {
   using std::log10;
   using std::max;
+  auto fileSize = utils::countFileLines(m_filename);
+  if (!utils::fileExists(m_filename) || fileSize != (m_zSize * m_eSize))
+    throw std::runtime_error("error reading from file : " + m_filename);
+  auto table = std::make_shared<Table>();
+  table->redshifts.reserve(m_zSize);
+  table->logPhotonEnergies.reserve(m_eSize);
+  table->logDensity.reserve(m_zSize * m_eSize);
+  table->logIgamma.reserve(m_zSize * m_eSize);
   auto v = utils::loadFileByRow(m_filename, ",");
   size_t counter = 0;
   for (size_t i = 0; i < m_zSize; ++i) {
@@ -39,22 +41,24 @@ void LookupTablePhotonField::loadDataFile() {
       auto eps = line[1] * SI::eV;
       auto n = line[2] * (1. / SI::eV / SI::m3);
       auto I_gamma = line[3] * (1. / pow2(SI::eV) / SI::m3);
-      if (j == 0) m_redshifts.emplace_back(z);
-      if (i == 0) m_logPhotonEnergies.emplace_back(log10(eps));
-      m_logDensity.emplace_back(log10(max(n, 1e-30)));
-      m_logIgamma.emplace_back(log10(max(I_gamma, 1e-30)));
+      if (j == 0) table->redshifts.emplace_back(z);
+      if (i == 0) table->logPhotonEnergies.emplace_back(log10(eps));
+      table->logDensity.emplace_back(log10(max(n, 1e-30)));
+      table->logIgamma.emplace_back(log10(max(I_gamma, 1e-30)));
       counter++;
     }
   }
-  assert(m_redshifts.size() == m_zSize && m_logPhotonEnergies.size() == m_eSize);
+  assert(table->redshifts.size() == m_zSize && table->logPhotonEnergies.size() == m_eSize);
+  return table;
 }
 
 double LookupTablePhotonField::density(double epsRestFrame, double z) const {
   double value = 0;
   auto loge = std::log10(epsRestFrame);
-  if (utils::isInside(z, m_redshifts) && utils::isInside(loge, m_logPhotonEnergies)) {
-    auto logn = utils::interpolate2d(z, loge, m_redshifts, m_logPhotonEnergies,
-                                     m_logDensity);  // TODO(CE) speed up this
+  const auto& t = *m_table;
+  if (utils::isInside(z, t.redshifts) && utils::isInside(loge, t.logPhotonEnergies)) {
+    auto logn = utils::interpolate2d(z, loge, t.redshifts, t.logPhotonEnergies,
+                                     t.logDensity);  // TODO(CE) speed up this
     value = std::pow(10., logn);
   }
   return std::max(value, 0.);
@@ -63,8 +67,9 @@ double LookupTablePhotonField::density(double epsRestFrame, double z) const {
 double LookupTablePhotonField::I_gamma(double epsRestFrame, double z) const {
   double value = 0;
   auto loge = std::log10(epsRestFrame);
-  if (utils::isInside(z, m_redshifts) && utils::isInside(loge, m_logPhotonEnergies)) {
-    auto logn = utils::interpolate2d(z, loge, m_redshifts, m_logPhotonEnergies, m_logIgamma);
+  const auto& t = *m_table;
+  if (utils::isInside(z, t.redshifts) && utils::isInside(loge, t.logPhotonEnergies)) {
+    auto logn = utils::interpolate2d(z, loge, t.redshifts, t.logPhotonEnergies, t.logIgamma);
     value = std::pow(10., logn);
   }
   return value;
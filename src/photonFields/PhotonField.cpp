@@ -1,6 +1,7 @@
 // Copyright 2023 SimProp-dev [MIT License]
 #include "simprop/photonFields/PhotonField.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "simprop/utils/numeric.h"
@@ -8,6 +9,18 @@
 namespace simprop {
 namespace photonfields {
 
+void PhotonField::batchDensity(const std::vector<double>& epsRestFrame, double z,
+                               std::vector<double>& values) const {
+  values.resize(epsRestFrame.size());
+  for (size_t i = 0; i < epsRestFrame.size(); ++i) values[i] = density(epsRestFrame[i], z);
+}
+
+void PhotonField::batchIgamma(const std::vector<double>& epsRestFrame, double z,
+                              std::vector<double>& values) const {
+  values.resize(epsRestFrame.size());
+  for (size_t i = 0; i < epsRestFrame.size(); ++i) values[i] = I_gamma(epsRestFrame[i], z);
+}
+
 double PhotonField::computeIntegratedDensity(double z) const {
   auto lnEpsMin = std::log(getMinPhotonEnergy());
   auto lnEpsMax = std::log(getMaxPhotonEnergy());
@@ -20,5 +33,12 @@ double PhotonField::computeIntegratedDensity(double z) const {
   return value;
 }
 
+bool allSelfSimilar(const PhotonFields& photonFields) {
+  return std::all_of(photonFields.begin(), photonFields.end(),
+                     [](const std::shared_ptr<PhotonField>& field) {
+                       return field->isSelfSimilar();
+                     });
+}
+
 }  // namespace photonfields
 }  // namespace simprop
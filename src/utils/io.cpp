@@ -1,5 +1,8 @@
 #include "simprop/utils/io.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <cmath>
 #include <fstream>
@@ -87,8 +90,43 @@ std::vector<std::vector<double> > loadFileByRow(std::string filePath, std::strin
   return rows;
 }
 
-OutputFile::OutputFile(const std::string& name) : filename(name), out("output/" + name) {}
-OutputFile::~OutputFile() { LOGI << "created output file " << filename; }
+void writeBinaryString(std::ostream& out, const std::string& value) {
+  writeBinary<uint64_t>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+std::string readBinaryString(std::istream& in) {
+  const auto size = readBinary<uint64_t>(in);
+  std::string value(size, '\0');
+  in.read(&value[0], size);
+  if (!in) throw std::runtime_error("unexpected end of binary stream");
+  return value;
+}
+
+OutputFile::OutputFile(const std::string& name) : filename(name) {}
+OutputFile::~OutputFile() {
+  if (out.is_open()) {
+    LOGI << "created output file " << filename;
+  }
+}
+
+size_t OutputFile::sync() {
+  stream().flush();
+  return static_cast<size_t>(out.tellp());
+}
+
+void OutputFile::truncate(size_t size) {
+  if (out.is_open()) out.close();
+  // cut in place, a job killed meanwhile still finds the content written before the checkpoint
+  const auto path = "output/" + filename;
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0 || static_cast<size_t>(info.st_size) < size)
+    throw std::runtime_error("output file " + filename + " is shorter than expected");
+  if (::truncate(path.c_str(), static_cast<off_t>(size)) != 0)
+    throw std::runtime_error("cannot truncate output file " + filename);
+  out.open(path, std::ios::in | std::ios::out);
+  out.seekp(0, std::ios::end);
+}
 
 }  // namespace utils
 }  // namespace simprop
\ No newline at end of file
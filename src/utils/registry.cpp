@@ -0,0 +1,27 @@
+#include "simprop/utils/registry.h"
+
+namespace simprop {
+namespace utils {
+
+std::recursive_mutex& DataRegistry::mutex() {
+  static std::recursive_mutex m;
+  return m;
+}
+
+std::map<DataRegistry::Key, std::shared_ptr<const void>>& DataRegistry::entries() {
+  static std::map<Key, std::shared_ptr<const void>> m;
+  return m;
+}
+
+size_t DataRegistry::size() {
+  std::lock_guard<std::recursive_mutex> lock(mutex());
+  return entries().size();
+}
+
+void DataRegistry::clear() {
+  std::lock_guard<std::recursive_mutex> lock(mutex());
+  entries().clear();
+}
+
+}  // namespace utils
+}  // namespace simprop
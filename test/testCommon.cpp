@@ -1,4 +1,7 @@
+#include <cmath>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "simprop.h"
@@ -17,6 +20,52 @@ TEST(Common, energyToWavelenght) {
   EXPECT_NEAR(photonWavelenght, 1.23984193 * SI::micron, 1e-3 * SI::micron);
 }
 
+TEST(Common, dataRegistry) {
+  size_t nLoads = 0;
+  auto load = [&nLoads]() {
+    nLoads++;
+    return std::shared_ptr<const std::vector<double>>(
+        std::make_shared<std::vector<double>>(3, 1.));
+  };
+  const auto a = utils::DataRegistry::get<std::vector<double>>("test", load);
+  const auto b = utils::DataRegistry::get<std::vector<double>>("test", load);
+  EXPECT_EQ(nLoads, size_t(1));
+  EXPECT_EQ(a.get(), b.get());
+  const auto c = utils::DataRegistry::get<std::vector<double>>("other", load);
+  EXPECT_EQ(nLoads, size_t(2));
+  EXPECT_NE(a.get(), c.get());
+  utils::DataRegistry::clear();
+  EXPECT_EQ(utils::DataRegistry::size(), size_t(0));
+  EXPECT_EQ(a->size(), size_t(3));
+}
+
+TEST(Common, batchKernels) {
+  auto expectBatchEqual = [](const std::vector<double>& x, const std::vector<double>& values,
+                             const std::function<double(double)>& scalar) {
+    ASSERT_EQ(values.size(), x.size());
+    for (size_t i = 0; i < x.size(); ++i) {
+      const auto reference = scalar(x[i]);
+      EXPECT_NEAR(values[i], reference, 1e-12 * std::fabs(reference));
+    }
+  };
+  std::vector<double> values;
+  const auto k = utils::LogAxis<double>(0.5, 1e6, 200);
+  losses::phi(k, values);
+  expectBatchEqual(k, values, [](double x) { return losses::phi(x); });
+  const auto epsPrime = utils::LogAxis<double>(0.1 * SI::GeV, 1e5 * SI::GeV, 200);
+  losses::inelasticity(epsPrime, values);
+  expectBatchEqual(epsPrime, values, [](double x) { return losses::inelasticity(x); });
+  const auto s = utils::LogAxis<double>(1e-3 * SI::GeV2, 1e4 * SI::GeV2, 200);
+  BreitWheeler::sigmaInCoMFrame(s, values);
+  expectBatchEqual(s, values, [](double x) { return BreitWheeler::sigmaInCoMFrame(x); });
+  photonfields::CMB cmb;
+  const auto eps = utils::LogAxis<double>(1e-6 * SI::eV, 1. * SI::eV, 200);
+  cmb.batchDensity(eps, 2., values);
+  expectBatchEqual(eps, values, [&cmb](double x) { return cmb.density(x, 2.); });
+  cmb.batchIgamma(eps, 2., values);
+  expectBatchEqual(eps, values, [&cmb](double x) { return cmb.I_gamma(x, 2.); });
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,328 @@
+#include <sys/stat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+
+namespace simprop {
+
+class ToyInteraction : public interactions::Interaction {
+ public:
+  ToyInteraction(double scale = 1.) : m_scale(scale) {}
+  double rate(PID pid, double Gamma, double z) const override {
+    return m_scale * 1e-17 * pow3(1. + z);
+  }
+  void finalState(const Particle& particle, double zInteractionPoint, RandomNumberGenerator& rng,
+                  std::vector<Particle>& secondaries) const override {
+    const auto fraction = 0.5 + 0.4 * rng();
+    const auto Gamma = particle.getGamma();
+    secondaries.emplace_back(proton, zInteractionPoint, fraction * Gamma, particle.getWeight());
+    secondaries.emplace_back(photon, zInteractionPoint, (1. - fraction) * Gamma,
+                             particle.getWeight());
+  }
+
+ protected:
+  double m_scale;
+};
+
+void setupToyEvolutor(evolutors::SingleProtonEvolutor& evolutor) {
+  auto cosmology = std::make_shared<cosmo::Cosmology>();
+  evolutor.addCosmology(cosmology);
+  evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+  evolutor.addInteractions({std::make_shared<ToyInteraction>()});
+}
+
+ParticleStack buildToyStack(RandomNumberGenerator& rng, size_t size) {
+  ParticleStack stack;
+  for (size_t i = 0; i < size; ++i) stack.push_back(Particle(proton, 0.5, 1e12 * (1. + rng())));
+  return stack;
+}
+
+void expectIdentical(const ParticleStack& a, const ParticleStack& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_TRUE(a[i].getPid() == b[i].getPid());
+    EXPECT_EQ(a[i].getRedshift(), b[i].getRedshift());
+    EXPECT_EQ(a[i].getGamma(), b[i].getGamma());
+    EXPECT_EQ(a[i].getOrigin().Gamma, b[i].getOrigin().Gamma);
+    EXPECT_EQ(a[i].isActive(), b[i].isActive());
+  }
+}
+
+void evolveToyStack(RandomNumberGenerator& rng, const std::string& checkpoint, bool doResume,
+                    const std::string& observed, size_t nThreads = 1) {
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  setupToyEvolutor(evolutor);
+  evolutor.addObservers({std::make_shared<observers::FileObserver>(observed)});
+  evolutor.setThreads(nThreads);
+  evolutor.setCheckpoint(checkpoint, 3);
+  ParticleStack stack;
+  if (doResume) {
+    evolutor.resume(checkpoint, stack);
+  } else {
+    stack = buildToyStack(rng, 40);
+    evolutor.run(stack);
+  }
+}
+
+TEST(Checkpoint, resumeIsBitIdentical) {
+  const std::string filename = "test_checkpoint.bin";
+  const std::string observed = "test_checkpoint_particles.txt";
+  auto readOutput = [](const std::string& name) {
+    std::ifstream in("output/" + name);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+  };
+  mkdir("output", 0755);
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  evolveToyStack(rng, filename, false, observed);
+  const auto referenceOutput = readOutput(observed);
+  EXPECT_FALSE(referenceOutput.empty());
+
+  // the last checkpoint was taken after 39 primaries, resume it with an unrelated generator: the
+  // observer keeps what it wrote before the checkpoint and appends the rest
+  RandomNumberGenerator otherRng = utils::RNG<double>(1);
+  evolveToyStack(otherRng, filename, true, observed);
+  std::remove(filename.c_str());
+  EXPECT_EQ(readOutput(observed), referenceOutput);
+
+  // a parallel run checkpoints the primaries observed so far, wherever the others are; a run
+  // whose observed prefix jumped over the last intervals has no checkpoint to resume
+  for (size_t nThreads : {4, 8}) {
+    rng = utils::RNG<double>(1234);
+    evolveToyStack(rng, filename, false, observed, nThreads);
+    EXPECT_EQ(readOutput(observed), referenceOutput);
+    if (!std::ifstream(filename)) continue;
+    evolveToyStack(otherRng, filename, true, observed, nThreads);
+    std::remove(filename.c_str());
+    EXPECT_EQ(readOutput(observed), referenceOutput);
+  }
+  std::remove(("output/" + observed).c_str());
+}
+
+TEST(Checkpoint, needsObservers) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  setupToyEvolutor(evolutor);
+  evolutor.setCheckpoint("test_checkpoint.bin");
+  auto stack = buildToyStack(rng, 4);
+  EXPECT_THROW(evolutor.run(stack), std::runtime_error);
+}
+
+TEST(Evolutor, independentOfThreads) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  const auto primaries = buildToyStack(rng, 20);
+  std::vector<ParticleStack> results;
+  for (size_t nThreads : {1, 3, 8}) {
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    setupToyEvolutor(evolutor);
+    evolutor.setSeed(42);
+    evolutor.setThreads(nThreads);
+    auto stack = primaries;
+    evolutor.run(stack);
+    results.push_back(stack);
+  }
+  expectIdentical(results[0], results[1]);
+  expectIdentical(results[0], results[2]);
+}
+
+TEST(Evolutor, replacingPhysicsDropsTables) {
+  RandomNumberGenerator rng = utils::RNG<double>(2468);
+  const auto primaries = buildToyStack(rng, 10);
+  auto evolve = [&](bool isCachedBefore) {
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    setupToyEvolutor(evolutor);
+    evolutor.setSeed(42);
+    if (isCachedBefore) {
+      evolutor.doCachingTotalLosses();
+      evolutor.doCachingOpacities();
+    }
+    auto cosmology = std::make_shared<cosmo::Cosmology>();
+    evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology),
+                        std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+    evolutor.addInteractions({std::make_shared<ToyInteraction>(3.)});
+    auto stack = primaries;
+    evolutor.run(stack);
+    return stack;
+  };
+  expectIdentical(evolve(false), evolve(true));
+}
+
+TEST(Evolutor, replayPrimary) {
+  RandomNumberGenerator rng = utils::RNG<double>(5678);
+  const auto primaries = buildToyStack(rng, 8);
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  setupToyEvolutor(evolutor);
+  auto stack = primaries;
+  evolutor.run(stack);
+
+  // the run seed was drawn from the user generator and is kept for replays
+  ParticleStack replayed;
+  for (size_t i = 0; i < primaries.size(); ++i) {
+    const auto cascade = evolutor.replay(primaries[i], i);
+    replayed.insert(replayed.end(), cascade.begin(), cascade.end());
+  }
+  expectIdentical(stack, replayed);
+}
+
+TEST(Checkpoint, rngState) {
+  RandomNumberGenerator rng = utils::RNG<double>(42);
+  rng();
+  const auto state = rng.getState();
+  const auto r1 = rng();
+  const auto r2 = rng();
+  RandomNumberGenerator other = utils::RNG<double>(7);
+  other.setState(state);
+  EXPECT_EQ(other(), r1);
+  EXPECT_EQ(other(), r2);
+}
+
+TEST(Evolutor, runStats) {
+  RandomNumberGenerator rng = utils::RNG<double>(4321);
+  const auto primaries = buildToyStack(rng, 12);
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  setupToyEvolutor(evolutor);
+  auto stats = std::make_shared<evolutors::RunStats>(0.);
+  evolutor.addRunStats(stats);
+  evolutor.setThreads(2);
+  auto stack = primaries;
+  evolutor.run(stack);
+
+  // every interaction deactivates a proton and yields a proton and a photon
+  size_t nInteracted = 0;
+  for (const auto& particle : stack)
+    if (!particle.isActive()) nInteracted++;
+  EXPECT_EQ(stats->getPrimaries(), uint64_t(12));
+  EXPECT_EQ(stats->getInteractions(), uint64_t(nInteracted));
+  ASSERT_EQ(stats->getInteractionsPerChannel().size(), size_t(1));
+  EXPECT_EQ(stack.size(), 12 + 2 * nInteracted);
+  EXPECT_GE(stats->getSteps(), stats->getInteractions());
+  EXPECT_GE(stats->getPeakStack(), uint64_t(1));
+  EXPECT_GT(stats->getParticlesPerSecond(), 0.);
+}
+
+TEST(Evolutor, nullCollisions) {
+  RandomNumberGenerator rng = utils::RNG<double>(2468);
+  const auto primaries = buildToyStack(rng, 2000);
+  std::vector<double> interactionsPerPrimary;
+  std::vector<uint64_t> rateEvaluations;
+  std::vector<uint64_t> majorantViolations;
+  for (bool doMajorants : {false, true}) {
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    setupToyEvolutor(evolutor);
+    evolutor.setSeed(11);
+    if (doMajorants) evolutor.doCachingRateMajorants({proton});
+    auto stats = std::make_shared<evolutors::RunStats>(0.);
+    evolutor.addRunStats(stats);
+    auto stack = primaries;
+    evolutor.run(stack);
+    interactionsPerPrimary.push_back((double)stats->getInteractions() / 2000.);
+    rateEvaluations.push_back(stats->getRateEvaluations());
+    majorantViolations.push_back(stats->getMajorantViolations());
+  }
+  // same mean number of interactions, with the exact rates evaluated only at the candidates
+  const auto sigma = std::sqrt(interactionsPerPrimary[0] / 2000.);
+  EXPECT_NEAR(interactionsPerPrimary[1], interactionsPerPrimary[0], 5. * sigma);
+  EXPECT_LT(rateEvaluations[1], rateEvaluations[0] / 5);
+  // the interactions are only unbiased if the bound holds at every candidate
+  EXPECT_EQ(majorantViolations[1], uint64_t(0));
+}
+
+TEST(Evolutor, opacitySampling) {
+  RandomNumberGenerator rng = utils::RNG<double>(1357);
+  const auto primaries = buildToyStack(rng, 2000);
+  std::vector<double> interactionsPerPrimary;
+  for (bool doOpacities : {false, true}) {
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    setupToyEvolutor(evolutor);
+    evolutor.setSeed(13);
+    if (doOpacities) evolutor.doCachingOpacities({proton});
+    auto stats = std::make_shared<evolutors::RunStats>(0.);
+    evolutor.addRunStats(stats);
+    auto stack = primaries;
+    evolutor.run(stack);
+    interactionsPerPrimary.push_back((double)stats->getInteractions() / 2000.);
+    // the rates are evaluated only to choose the channel at the sampled interaction points
+    if (doOpacities) {
+      EXPECT_EQ(stats->getRateEvaluations(), stats->getInteractions());
+    }
+  }
+  const auto sigma = std::sqrt(interactionsPerPrimary[0] / 2000.);
+  EXPECT_NEAR(interactionsPerPrimary[1], interactionsPerPrimary[0], 5. * sigma);
+}
+
+TEST(Evolutor, cachedTotalLosses) {
+  RandomNumberGenerator rng = utils::RNG<double>(97);
+  std::vector<double> finalGamma;
+  for (bool doCaching : {false, true}) {
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    auto cosmology = std::make_shared<cosmo::Cosmology>();
+    evolutor.addCosmology(cosmology);
+    evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+    if (doCaching) evolutor.doCachingTotalLosses({proton});
+    ParticleStack stack{Particle(proton, 0.5, 1e10)};
+    evolutor.run(stack);
+    ASSERT_EQ(stack.size(), size_t(1));
+    finalGamma.push_back(stack[0].getGamma());
+  }
+  // adiabatic losses keep Gamma (1+z) constant
+  EXPECT_NEAR(finalGamma[0] / (1e10 / 1.5), 1., 1e-3);
+  EXPECT_NEAR(finalGamma[1] / finalGamma[0], 1., 1e-4);
+}
+
+TEST(Evolutor, ensembleMatchesSingleProton) {
+  RandomNumberGenerator rng = utils::RNG<double>(8642);
+  const auto primaries = buildToyStack(rng, 2000);
+  std::vector<ParticleStack> results;
+  std::vector<double> interactionsPerPrimary;
+  auto evolve = [&](evolutors::SingleProtonEvolutor& evolutor) {
+    setupToyEvolutor(evolutor);
+    evolutor.setSeed(17);
+    auto stats = std::make_shared<evolutors::RunStats>(0.);
+    evolutor.addRunStats(stats);
+    auto stack = primaries;
+    evolutor.run(stack);
+    EXPECT_EQ(stats->getPrimaries(), uint64_t(2000));
+    EXPECT_EQ(stack.size(), 2000 + 2 * stats->getInteractions());
+    interactionsPerPrimary.push_back((double)stats->getInteractions() / 2000.);
+    results.push_back(stack);
+  };
+  evolutors::SingleProtonEvolutor single(rng);
+  evolve(single);
+  evolutors::EnsembleEvolutor ensemble(rng);
+  evolve(ensemble);
+  const auto sigma = std::sqrt(interactionsPerPrimary[0] / 2000.);
+  EXPECT_NEAR(interactionsPerPrimary[1], interactionsPerPrimary[0], 5. * sigma);
+
+  // mean and standard error of ln Gamma of the observed protons and photons
+  for (const auto pid : {proton, photon}) {
+    std::vector<double> mean, error;
+    for (const auto& stack : results) {
+      double sum = 0, sum2 = 0, n = 0;
+      for (const auto& particle : stack) {
+        if (particle.getPid() != pid || (pid == proton && !particle.isActive())) continue;
+        const auto lnGamma = std::log(particle.getGamma());
+        sum += lnGamma;
+        sum2 += lnGamma * lnGamma;
+        n++;
+      }
+      mean.push_back(sum / n);
+      error.push_back(std::sqrt((sum2 / n - pow2(sum / n)) / n));
+    }
+    EXPECT_NEAR(mean[1], mean[0], 5. * std::hypot(error[0], error[1]));
+  }
+
+  // every particle draws from the stream of its primary, the block size does not matter
+  evolutors::EnsembleEvolutor other(rng);
+  other.setBlockSize(1);
+  evolve(other);
+  expectIdentical(results[1], results[2]);
+}
+
+}  // namespace simprop
@@ -0,0 +1,42 @@
+#include <cmath>
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+
+namespace simprop {
+
+TEST(LossesTable, constantLosses) {
+  auto table = evolutors::LossesCharacteristicTable(10, 101);
+  table.cacheTable([](double Gamma, double z) { return 2.; }, {1e6, 1e14}, {0., 10.});
+  EXPECT_TRUE(table.isInside(1e10, 5.));
+  EXPECT_FALSE(table.isInside(1e15, 5.));
+  EXPECT_FALSE(table.isInside(1e10, 11.));
+  EXPECT_NEAR(table.get(1e10, 0.), 0., 1e-12);
+  EXPECT_NEAR(table.get(1e10, 3.33), 6.66, 1e-10);
+  EXPECT_NEAR(table.findRedshift(1e10, 6.66), 3.33, 1e-10);
+  EXPECT_DOUBLE_EQ(table.findRedshift(1e10, -1.), 0.);
+}
+
+TEST(LossesTable, inversion) {
+  auto table = evolutors::LossesCharacteristicTable(100, 1001);
+  auto betaDtdz = [](double Gamma, double z) { return std::log(Gamma) * pow2(1. + z); };
+  table.cacheTable(betaDtdz, {1e6, 1e14}, {0., 5.});
+  for (double Gamma : {1e7, 1e9, 1e13}) {
+    for (double z : {0.1, 1., 4.}) {
+      const auto exact = std::log(Gamma) * (pow3(1. + z) - 1.) / 3.;
+      EXPECT_NEAR(table.get(Gamma, z) / exact, 1., 1e-4);
+      EXPECT_NEAR(table.findRedshift(Gamma, exact), z, 1e-4);
+    }
+  }
+}
+
+TEST(LossesTable, opacitySampling) {
+  auto table = evolutors::OpacityTable(10, 101);
+  table.cacheTable([](double Gamma, double z) { return 2.; }, {1e6, 1e14}, {0., 10.});
+  EXPECT_NEAR(table.sampleRedshiftInterval(1e10, 5., 1. - std::exp(-4.)), 2., 1e-10);
+  EXPECT_EQ(table.sampleRedshiftInterval(1e10, 1., 1. - std::exp(-4.)),
+            std::numeric_limits<double>::max());
+}
+
+}  // namespace simprop
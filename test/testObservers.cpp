@@ -0,0 +1,158 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+
+namespace simprop {
+
+class CountingObserver : public observers::Observer {
+ public:
+  void observe(const Particle& particle) override {
+    m_counter++;
+    m_weight += particle.getWeight();
+  }
+  size_t m_counter = 0;
+  double m_weight = 0;
+};
+
+class RecordingObserver : public observers::Observer {
+ public:
+  void observe(const Particle& particle) override { m_particles.push_back(particle); }
+  ParticleStack m_particles;
+};
+
+TEST(Observers, histogram) {
+  observers::HistogramObserver histogram({1e18 * SI::eV, 1e20 * SI::eV}, 2);
+  const auto Gamma = 3e18 * SI::eV / SI::protonMassC2;
+  histogram.observe(Particle(proton, 0., Gamma, 2.));
+  histogram.observe(Particle(proton, 0., 30. * Gamma, 1.));
+  histogram.observe(Particle(proton, 0., 1e-2 * Gamma, 1.));
+  histogram.observe(Particle(proton, 0., 1e3 * Gamma, 0.5));
+  EXPECT_DOUBLE_EQ(histogram.getCounts()[0], 2.);
+  EXPECT_DOUBLE_EQ(histogram.getCounts()[1], 1.);
+  EXPECT_DOUBLE_EQ(histogram.getUnderflow(), 1.);
+  EXPECT_DOUBLE_EQ(histogram.getOverflow(), 0.5);
+  EXPECT_NEAR(histogram.getEnergyAxis()[0], 1e18 * SI::eV * std::sqrt(10.), 1e-6 * SI::eV * 1e18);
+}
+
+TEST(Observers, filter) {
+  auto counter = std::make_shared<CountingObserver>();
+  observers::FilterObserver filter(observers::IsSpecies({neutrino_e, neutrino_mu}), {counter});
+  filter.observe(Particle(neutrino_e, 0.1, 1e10, 0.5));
+  filter.observe(Particle(proton, 0.1, 1e10, 1.));
+  filter.observe(Particle(neutrino_mu, 0.2, 1e10, 0.25));
+  EXPECT_EQ(counter->m_counter, size_t(2));
+  EXPECT_DOUBLE_EQ(counter->m_weight, 0.75);
+}
+
+TEST(Observers, evolutorStreamsFinishedParticles) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  auto cosmology = std::make_shared<cosmo::Cosmology>();
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  evolutor.addCosmology(cosmology);
+  evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+  auto counter = std::make_shared<CountingObserver>();
+  evolutor.addObservers({counter});
+  ParticleStack stack{Particle(proton, 0.1, 1e10), Particle(proton, 0.2, 1e11),
+                      Particle(photon, 0.1, 1e10)};
+  evolutor.run(stack);
+  EXPECT_TRUE(stack.empty());
+  EXPECT_EQ(counter->m_counter, size_t(3));
+}
+
+TEST(Observers, orderIndependentOfThreads) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  ParticleStack primaries;
+  for (size_t i = 0; i < 50; ++i) primaries.push_back(Particle(proton, 0.5, 1e10 * (1. + rng())));
+  std::vector<ParticleStack> observed;
+  for (size_t nThreads : {1, 4}) {
+    auto cosmology = std::make_shared<cosmo::Cosmology>();
+    evolutors::SingleProtonEvolutor evolutor(rng);
+    evolutor.addCosmology(cosmology);
+    evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+    evolutor.setThreads(nThreads);
+    auto recorder = std::make_shared<RecordingObserver>();
+    evolutor.addObservers({recorder});
+    auto stack = primaries;
+    evolutor.run(stack);
+    EXPECT_TRUE(stack.empty());
+    observed.push_back(recorder->m_particles);
+  }
+  // the cascades are handed over in primary order whatever the scheduling
+  ASSERT_EQ(observed[0].size(), primaries.size());
+  ASSERT_EQ(observed[1].size(), primaries.size());
+  for (size_t i = 0; i < primaries.size(); ++i) {
+    EXPECT_EQ(observed[0][i].getOrigin().Gamma, primaries[i].getGamma());
+    EXPECT_EQ(observed[1][i].getOrigin().Gamma, primaries[i].getGamma());
+  }
+}
+
+// the first losses evaluation of a primary is at its initial redshift, the high energy primary is
+// slow to evolve
+class StartTrackingLosses : public losses::ContinuousLosses {
+ public:
+  StartTrackingLosses(const std::shared_ptr<cosmo::Cosmology>& cosmology,
+                      const std::set<double>& initialRedshifts)
+      : m_adiabatic(cosmology), m_initialRedshifts(initialRedshifts) {}
+  double beta(PID pid, double Gamma, double z) const override {
+    if (m_initialRedshifts.count(z)) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_started.insert(z);
+    }
+    if (Gamma > 1e12) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    return m_adiabatic.beta(pid, Gamma, z);
+  }
+  size_t getStarted() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_started.size();
+  }
+
+ protected:
+  losses::AdiabaticContinuousLosses m_adiabatic;
+  std::set<double> m_initialRedshifts;
+  mutable std::set<double> m_started;
+  mutable std::mutex m_mutex;
+};
+
+class FirstObservationObserver : public observers::Observer {
+ public:
+  FirstObservationObserver(const StartTrackingLosses& losses) : m_losses(losses) {}
+  void observe(const Particle& particle) override {
+    if (m_nObserved++ == 0) m_startedAtFirst = m_losses.getStarted();
+  }
+  const StartTrackingLosses& m_losses;
+  size_t m_nObserved = 0;
+  size_t m_startedAtFirst = 0;
+};
+
+TEST(Observers, boundedLookAhead) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  ParticleStack primaries;
+  std::set<double> initialRedshifts;
+  for (size_t i = 0; i < 200; ++i) {
+    const auto z = 0.4 + 0.1 * rng();
+    primaries.push_back(Particle(proton, z, (i == 0) ? 1e13 : 1e10));
+    initialRedshifts.insert(z);
+  }
+  auto cosmology = std::make_shared<cosmo::Cosmology>();
+  auto losses = std::make_shared<StartTrackingLosses>(cosmology, initialRedshifts);
+  auto observer = std::make_shared<FirstObservationObserver>(*losses);
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  evolutor.addCosmology(cosmology);
+  evolutor.addLosses({losses});
+  evolutor.addObservers({observer});
+  evolutor.setThreads(4);
+  auto stack = primaries;
+  evolutor.run(stack);
+  EXPECT_EQ(losses->getStarted(), primaries.size());
+  // while the slow first primary is evolved the other workers stop at 8 primaries per thread
+  EXPECT_GT(observer->m_startedAtFirst, size_t(4));
+  EXPECT_LE(observer->m_startedAtFirst, size_t(32));
+}
+
+}  // namespace simprop
@@ -0,0 +1,75 @@
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+
+namespace simprop {
+
+TEST(PhotoDisintegration, cachedRates) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoDisintegration pd(cmb);
+  const std::vector<PID> isotopes = {Fe56, Si28, N14, C12, getPidNucleus(25, 55)};
+  const std::vector<double> Gammas = {2e9, 3e10, 5e11};
+  const std::vector<double> redshifts = {0., 0.55, 2.};
+  std::vector<double> exact;
+  for (auto pid : isotopes)
+    for (auto Gamma : Gammas)
+      for (auto z : redshifts) exact.push_back(pd.rate(pid, Gamma, z));
+
+  pd.doCaching();
+  size_t counter = 0;
+  for (auto pid : isotopes) {
+    for (auto Gamma : Gammas) {
+      for (auto z : redshifts) {
+        const auto cached = pd.rate(pid, Gamma, z);
+        const auto value = exact[counter++];
+        EXPECT_GT(value, 0.);
+        EXPECT_NEAR(cached / value, 1., 0.005);
+      }
+    }
+  }
+  // isotopes without TALYS channels and Gamma outside the tables
+  EXPECT_EQ(pd.rate(proton, 1e10), 0.);
+  interactions::PhotoDisintegration reference(cmb);
+  EXPECT_DOUBLE_EQ(pd.rate(Fe56, 1e15, 0.), reference.rate(Fe56, 1e15, 0.));
+}
+
+TEST(PhotoDisintegration, finalState) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoDisintegration cached(cmb);
+  cached.doCaching();
+  interactions::PhotoDisintegration reference(cmb);
+  RandomNumberGenerator rng = utils::RNG<double>(12);
+  const auto pid = Fe56;
+  const auto Gamma = 3e10;
+  const auto z = 0.5;
+  const auto alphaFraction = [&](const interactions::PhotoDisintegration& pd, size_t N) {
+    size_t nAlpha = 0;
+    std::vector<Particle> secondaries;
+    for (size_t i = 0; i < N; ++i) {
+      secondaries.clear();
+      pd.finalState(Particle(pid, 1., Gamma), z, rng, secondaries);
+      EXPECT_EQ(secondaries.size(), size_t(2));
+      int A = 0, Z = 0;
+      for (const auto& secondary : secondaries) {
+        EXPECT_DOUBLE_EQ(secondary.getGamma(), Gamma);
+        EXPECT_DOUBLE_EQ(secondary.getRedshift(), z);
+        A += getPidNucleusMassNumber(secondary.getPid());
+        Z += getPidNucleusCharge(secondary.getPid());
+        if (secondary.getPid() == He4) nAlpha++;
+      }
+      EXPECT_EQ(A, getPidNucleusMassNumber(pid));
+      EXPECT_EQ(Z, getPidNucleusCharge(pid));
+    }
+    return (double)nAlpha / (double)N;
+  };
+  const auto fractionCached = alphaFraction(cached, 100000);
+  const auto fractionReference = alphaFraction(reference, 2000);
+  EXPECT_GT(fractionCached, 0.);
+  EXPECT_LT(fractionCached, 0.5);
+  EXPECT_NEAR(fractionCached, fractionReference, 0.03);
+  EXPECT_EQ(cached.finalState(Particle(pid, 1., Gamma), z, rng).size(), size_t(2));
+}
+
+}  // namespace simprop
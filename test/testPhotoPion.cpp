@@ -0,0 +1,329 @@
+#include <sys/wait.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+#include "sophia_interface.h"
+
+namespace simprop {
+
+TEST(PhotoPion, tabulatedEpsSampling) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoPionProduction ppp(cmb);
+  ppp.doCachingEps();
+  for (auto nucleon : {proton, neutron}) {
+    for (double energy : {3e19 * SI::eV, 2e20 * SI::eV}) {
+      for (double z : {0., 1.3}) {
+        for (double r : {0.1, 0.5, 0.9}) {
+          const auto exact = ppp.sampleEpsExact(r, nucleon, energy, z);
+          const auto tabulated = ppp.sampleEps(r, nucleon, energy, z);
+          EXPECT_NEAR(tabulated / exact, 1., 0.02);
+        }
+      }
+    }
+  }
+  ppp.setReferenceSampling(true);
+  EXPECT_DOUBLE_EQ(ppp.sampleEps(0.3, proton, 1e20 * SI::eV, 0.5),
+                   ppp.sampleEpsExact(0.3, proton, 1e20 * SI::eV, 0.5));
+}
+
+TEST(PhotoPion, tabulatedSSampling) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoPionProduction ppp(cmb);
+  for (auto nucleon : {proton, neutron}) {
+    for (double sMax : {1.2, 1.6, 4., 40., 1e3}) {
+      for (double r : {0.01, 0.1, 0.5, 0.9, 1.}) {
+        const auto exact = ppp.sampleSExact(r, nucleon, sMax * SI::GeV2);
+        const auto tabulated = ppp.sampleS(r, nucleon, sMax * SI::GeV2);
+        EXPECT_NEAR(tabulated / exact, 1., 1e-3);
+      }
+    }
+  }
+  EXPECT_EQ(ppp.sampleS(0.5, proton, SI::GeV2), 0.);
+}
+
+TEST(PhotoPion, sophiaEventLibrary) {
+  const Range sqrtsRange = {1.1 * SI::GeV, 100. * SI::GeV};
+  interactions::SophiaEventLibrary library(sqrtsRange, 10, 2, "test");
+  EXPECT_TRUE(library.add(proton, 2. * SI::GeV, {{proton, 0.75}, {pionNeutral, 0.25}}));
+  EXPECT_TRUE(library.add(proton, 2.01 * SI::GeV, {{neutron, 0.5}, {pionPlus, 0.5}}));
+  EXPECT_FALSE(library.add(proton, 2.02 * SI::GeV, {{proton, 1.}}));
+  EXPECT_FALSE(library.add(neutron, 200. * SI::GeV, {{neutron, 1.}}));
+  EXPECT_TRUE(library.isFull(proton, library.findBin(2. * SI::GeV)));
+  EXPECT_EQ(library.getEventsSize(neutron, library.findBin(2. * SI::GeV)), size_t(0));
+
+  library.save("test_library.bin");
+  const auto loaded = interactions::SophiaEventLibrary::load("test_library.bin");
+  std::remove("test_library.bin");
+  EXPECT_TRUE(loaded.hasParameters(sqrtsRange, 10, 2, "test"));
+  EXPECT_FALSE(loaded.hasParameters(sqrtsRange, 10, 3, "test"));
+  EXPECT_FALSE(loaded.hasParameters(sqrtsRange, 10, 2, "other"));
+  EXPECT_FALSE(loaded.hasParameters({1.1 * SI::GeV, 200. * SI::GeV}, 10, 2, "test"));
+
+  const auto E = 1e20 * SI::eV;
+  std::vector<Particle> particles;
+  EXPECT_TRUE(loaded.sample(0.1, proton, 2. * SI::GeV, E, 0.5, 2., particles));
+  ASSERT_EQ(particles.size(), size_t(2));
+  EXPECT_EQ(particles[0].getPid(), proton);
+  EXPECT_NEAR(particles[0].getGamma() * SI::protonMassC2 / E, 0.75, 1e-6);
+  EXPECT_EQ(particles[1].getPid(), pionNeutral);
+  EXPECT_DOUBLE_EQ(particles[1].getRedshift(), 0.5);
+  EXPECT_DOUBLE_EQ(particles[1].getWeight(), 2.);
+  EXPECT_FALSE(loaded.sample(0.1, neutron, 2. * SI::GeV, E, 0.5, 2., particles));
+  EXPECT_FALSE(loaded.sample(0.1, proton, 1e3 * SI::GeV, E, 0.5, 2., particles));
+}
+
+TEST(PhotoPion, sophiaLibraryConservesEnergy) {
+  const auto library = interactions::PhotoPionProductionSophia::generateEventLibrary(32, 20);
+  const auto E = 1e20 * SI::eV;
+  for (auto nucleon : {proton, neutron}) {
+    for (double sqrts : {1.3, 2., 10., 100.}) {
+      std::vector<Particle> particles;
+      ASSERT_TRUE(library->sample(0.5, nucleon, sqrts * SI::GeV, E, 0., 1., particles));
+      double energy = 0;
+      for (const auto& particle : particles) {
+        const auto mass = getPidMass(particle.getPid());
+        energy += (mass > 0.) ? particle.getGamma() * mass : particle.getGamma();
+      }
+      EXPECT_NEAR(energy / E, 1., 1e-5);
+    }
+  }
+  library->save("test_library.bin");
+  EXPECT_NO_THROW(
+      interactions::PhotoPionProductionSophia::loadEventLibrary("test_library.bin", 32, 20));
+  EXPECT_THROW(interactions::PhotoPionProductionSophia::loadEventLibrary("test_library.bin"),
+               std::runtime_error);
+  std::remove("test_library.bin");
+}
+
+TEST(PhotoPion, sophiaWorkersThroughput) {
+  interactions::SophiaWorkerPool pool(4);
+  const double Ein = 100.;  // GeV
+  const double eps = 0.1;
+  const size_t nEvents = 2048;
+  for (size_t nThreads : {1, 8, 32}) {
+    std::atomic<size_t> nValid(0);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThreads; ++i) {
+      threads.emplace_back([&, i] {
+        sophiaevent_output seo;
+        for (size_t j = i; j < nEvents; j += nThreads) {
+          pool.event(j % 2 == 0, Ein, eps, j, seo);
+          double energy = 0;
+          for (int k = 0; k < seo.Nout; ++k) energy += seo.outPartP[3][k];
+          if (seo.Nout > 1 && std::fabs(energy / (Ein + eps) - 1.) < 1e-3) nValid++;
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(nValid.load(), nEvents);
+    const auto throughput = (double)nEvents / elapsed.count();
+    RecordProperty("eventsPerSecond" + std::to_string(nThreads), std::to_string(throughput));
+  }
+}
+
+// exposes the per-worker call to send the same requests to each worker
+class SophiaWorkerPoolProbe : public interactions::SophiaWorkerPool {
+ public:
+  using SophiaWorkerPool::event;
+  using SophiaWorkerPool::SophiaWorkerPool;
+  pid_t getWorkerPid(size_t iWorker) const { return m_workers.at(iWorker).pid; }
+};
+
+bool isSameEvent(const sophiaevent_output& a, const sophiaevent_output& b) {
+  if (a.Nout != b.Nout) return false;
+  for (int k = 0; k < a.Nout; ++k)
+    if (a.outPartID[k] != b.outPartID[k] || a.outPartP[3][k] != b.outPartP[3][k]) return false;
+  return true;
+}
+
+TEST(PhotoPion, sophiaWorkersFollowSeed) {
+  SophiaWorkerPoolProbe pool(2);
+  const double Ein = 100.;  // GeV
+  const double eps = 0.1;
+  size_t nDifferent = 0;
+  for (uint64_t seed = 0; seed < 10; ++seed) {
+    // the same request gives the same event on every worker, whatever they ran before
+    std::vector<sophiaevent_output> events(3);
+    ASSERT_TRUE(pool.event(0, true, Ein, eps, seed, events[0]));
+    ASSERT_TRUE(pool.event(1, true, Ein, eps, seed, events[1]));
+    ASSERT_TRUE(pool.event(1, true, Ein, eps, seed + 100, events[2]));
+    EXPECT_TRUE(isSameEvent(events[0], events[1]));
+    if (!isSameEvent(events[0], events[2])) nDifferent++;
+  }
+  EXPECT_GT(nDifferent, size_t(5));
+}
+
+TEST(PhotoPion, sophiaDeadWorker) {
+  SophiaWorkerPoolProbe pool(1);
+  kill(pool.getWorkerPid(0), SIGKILL);
+  waitpid(pool.getWorkerPid(0), nullptr, 0);
+  sophiaevent_output seo;
+  EXPECT_THROW(pool.event(true, 100., 0.1, 1, seo), std::runtime_error);
+  // the failure is reported without changing how the process handles SIGPIPE
+  struct sigaction action;
+  sigaction(SIGPIPE, nullptr, &action);
+  EXPECT_TRUE(action.sa_handler == SIG_DFL);
+}
+
+TEST(PhotoPion, sophiaWorkersFinalState) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoPionProductionSophia ppp(cmb);
+  ppp.setWorkers(2);
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  const auto Gamma = 1e20 * SI::eV / SI::protonMassC2;
+  const auto finalState = ppp.finalState({proton, 0.1, Gamma}, 0.1, rng);
+  EXPECT_GT(finalState.size(), size_t(1));
+  for (const auto& particle : finalState) EXPECT_DOUBLE_EQ(particle.getRedshift(), 0.1);
+}
+
+// cascades with SOPHIA final states, evolved with nThreads and optionally a worker pool
+ParticleStack evolveSophiaCascades(const ParticleStack& primaries, size_t nThreads,
+                                   size_t nWorkers, ParticleStack* replayed = nullptr) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  auto cosmology = std::make_shared<cosmo::Cosmology>();
+  auto ppp = std::make_shared<interactions::PhotoPionProductionSophia>(cmb);
+  ppp->doCaching();
+  ppp->setWorkers(nWorkers);
+  RandomNumberGenerator rng = utils::RNG<double>(1);
+  evolutors::SingleProtonEvolutor evolutor(rng);
+  evolutor.addCosmology(cosmology);
+  evolutor.addLosses({std::make_shared<losses::AdiabaticContinuousLosses>(cosmology)});
+  evolutor.addInteractions({ppp});
+  evolutor.setSeed(2023);
+  evolutor.setThreads(nThreads);
+  auto stack = primaries;
+  evolutor.run(stack);
+  if (replayed) {
+    for (size_t i = 0; i < primaries.size(); ++i) {
+      const auto cascade = evolutor.replay(primaries[i], i);
+      replayed->insert(replayed->end(), cascade.begin(), cascade.end());
+    }
+  }
+  return stack;
+}
+
+TEST(PhotoPion, sophiaIndependentOfThreads) {
+  ParticleStack primaries;
+  for (size_t i = 0; i < 8; ++i) primaries.push_back(Particle(proton, 0.05, 3e11 * (1. + i)));
+  ParticleStack replayed;
+  const auto reference = evolveSophiaCascades(primaries, 1, 0, &replayed);
+  EXPECT_GT(reference.size(), 4 * primaries.size());
+  // the serialized SOPHIA calls and the worker pool follow the per-primary streams
+  for (const auto& result :
+       {evolveSophiaCascades(primaries, 4, 0), evolveSophiaCascades(primaries, 4, 4), replayed}) {
+    ASSERT_EQ(result.size(), reference.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+      EXPECT_TRUE(result[i].getPid() == reference[i].getPid());
+      EXPECT_EQ(result[i].getRedshift(), reference[i].getRedshift());
+      EXPECT_EQ(result[i].getGamma(), reference[i].getGamma());
+    }
+  }
+}
+
+TEST(PhotoPion, finalStateIntoBuffer) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  interactions::PhotoPionProduction ppp(cmb);
+  RandomNumberGenerator rng = utils::RNG<double>(77);
+  const auto Gamma = 1e20 * SI::eV / SI::protonMassC2;
+  std::vector<Particle> secondaries;
+  secondaries.reserve(8);
+  const auto data = secondaries.data();
+  for (size_t i = 0; i < 100; ++i) {
+    secondaries.clear();
+    ppp.finalState({Fe56, 0.1, Gamma}, 0.1, rng, secondaries);
+    EXPECT_EQ(secondaries.size(), size_t(3));
+    double energy = 0;
+    for (const auto& particle : secondaries)
+      energy += particle.getGamma() * getPidMass(particle.getPid());
+    EXPECT_NEAR(energy / (Gamma * getPidMass(Fe56)), 1., 1e-2);
+  }
+  // the buffer is filled in place and appended to
+  EXPECT_EQ(secondaries.data(), data);
+  ppp.finalState({proton, 0.1, Gamma}, 0.1, rng, secondaries);
+  EXPECT_EQ(secondaries.size(), size_t(5));
+}
+
+TEST(PhotoPion, fusedRateAndBeta) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  xsecs::PhotoPionXsec xs;
+  interactions::PhotoPionProduction uncached(cmb);
+  for (auto pid : {proton, neutron, Fe56}) {
+    for (auto Gamma : {3e10, 1e12}) {
+      for (auto z : {0., 2.}) {
+        const auto lnEpsPrimeMin =
+            std::log(std::max(xs.getEpsPrimeThreshold(), 2. * Gamma * cmb->getMinPhotonEnergy()));
+        const auto lnEpsPrimeMax = std::log(2. * Gamma * cmb->getMaxPhotonEnergy());
+        auto integrand = [&](double lnEpsPrime, bool withInelasticity) {
+          const auto epsPrime = std::exp(lnEpsPrime);
+          const auto value = epsPrime * epsPrime * xs.getAtEpsPrime(pid, epsPrime) *
+                             cmb->I_gamma(epsPrime / 2. / Gamma, z);
+          return (withInelasticity) ? value * losses::inelasticity(epsPrime) : value;
+        };
+        const auto factor = SI::cLight / 2. / pow2(Gamma);
+        const auto rate = factor * utils::simpsonIntegration<double>(
+                                       [&](double x) { return integrand(x, false); },
+                                       lnEpsPrimeMin, lnEpsPrimeMax, 20000);
+        const auto beta = factor * utils::simpsonIntegration<double>(
+                                       [&](double x) { return integrand(x, true); },
+                                       lnEpsPrimeMin, lnEpsPrimeMax, 20000);
+        const auto fused = interactions::computeRateAndBeta(xs, *cmb, pid, Gamma, z);
+        EXPECT_NEAR(fused.first / rate, 1., 5e-3);
+        EXPECT_NEAR(fused.second / beta, 1., 5e-3);
+        EXPECT_DOUBLE_EQ(uncached.rate(pid, Gamma, z), fused.first);
+      }
+    }
+  }
+  auto ppp = std::make_shared<interactions::PhotoPionProduction>(cmb);
+  losses::PhotoPionContinuousLosses shared(ppp);
+  losses::PhotoPionContinuousLosses standalone(cmb);
+  EXPECT_DOUBLE_EQ(shared.beta(proton, 1e11, 1.), standalone.beta(proton, 1e11, 1.));
+}
+
+TEST(PhotoPion, selfSimilarCaching) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  ASSERT_TRUE(cmb->isSelfSimilar());
+  interactions::PhotoPionProduction ppp(cmb);
+  ppp.doCaching();
+  xsecs::PhotoPionXsec xs;
+  for (auto pid : {proton, Fe56}) {
+    for (auto Gamma : {3e10, 1e12}) {
+      for (auto z : {0.5, 3.}) {
+        const auto exact = interactions::computeRateAndBeta(xs, *cmb, pid, Gamma, z);
+        EXPECT_NEAR(ppp.rate(pid, Gamma, z) / exact.first, 1., 1e-2);
+        EXPECT_NEAR(ppp.beta(pid, Gamma, z) / exact.second, 1., 1e-2);
+      }
+    }
+  }
+  // outside the tables both fall back to the integration
+  const auto outside = interactions::computeRateAndBeta(xs, *cmb, proton, 1e16, 0.);
+  EXPECT_DOUBLE_EQ(ppp.rate(proton, 1e16, 0.), outside.first);
+  EXPECT_DOUBLE_EQ(ppp.beta(proton, 1e16, 0.), outside.second);
+}
+
+TEST(PhotoPion, cachedContinuousLosses) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  losses::PhotoPionContinuousLosses exact(cmb);
+  losses::PhotoPionContinuousLosses cached(cmb);
+  cached.doCaching();
+  for (auto pid : {proton, neutron, Fe56}) {
+    for (auto Gamma : {3e10, 1e12}) {
+      for (auto z : {0., 2.}) {
+        EXPECT_NEAR(cached.beta(pid, Gamma, z) / exact.beta(pid, Gamma, z), 1., 1e-2);
+      }
+    }
+  }
+}
+
+}  // namespace simprop
@@ -24,6 +24,14 @@ TEST(PhotonFields, Dominguez2011) {
   EXPECT_DOUBLE_EQ(ebl.I_gamma(1e2 * SI::eV), 0.);
 }
 
+TEST(PhotonFields, allSelfSimilar) {
+  auto cmb = std::make_shared<photonfields::CMB>();
+  auto ebl = std::make_shared<photonfields::Dominguez2011PhotonField>();
+  EXPECT_TRUE(photonfields::allSelfSimilar({cmb}));
+  EXPECT_TRUE(photonfields::allSelfSimilar({cmb, cmb}));
+  EXPECT_FALSE(photonfields::allSelfSimilar({cmb, ebl}));
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
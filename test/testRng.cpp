@@ -1,4 +1,6 @@
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "simprop.h"
@@ -49,6 +51,75 @@ TEST(RNG, uniform) {
   }
 }
 
+TEST(RNG, philoxKnownAnswers) {
+  // reference vectors of the Random123 distribution
+  using Philox = utils::Philox4x32;
+  const auto zero = Philox::block({0, 0, 0, 0}, {0, 0});
+  EXPECT_EQ(zero, (Philox::counter_type{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  const auto ones = Philox::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                  {0xffffffff, 0xffffffff});
+  EXPECT_EQ(ones, (Philox::counter_type{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  const auto pi = Philox::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                {0xa4093822, 0x299f31d0});
+  EXPECT_EQ(pi, (Philox::counter_type{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(RNG, counterBasedStreams) {
+  RandomNumberGenerator a = utils::RNG<double>(uint64_t(1234), uint64_t(7));
+  RandomNumberGenerator b = utils::RNG<double>(uint64_t(1234), uint64_t(7));
+  RandomNumberGenerator c = utils::RNG<double>(uint64_t(1234), uint64_t(8));
+  size_t N = 1000000;
+  double sum = 0;
+  size_t nEqual = 0;
+  for (size_t i = 0; i < N; ++i) {
+    const auto r = a();
+    EXPECT_EQ(r, b());
+    if (r == c()) nEqual++;
+    EXPECT_GE(r, 0.0);
+    EXPECT_LT(r, 1.0);
+    sum += r;
+  }
+  EXPECT_NEAR(sum / (double)N, 0.5, 0.001);
+  EXPECT_EQ(nEqual, size_t(0));
+}
+
+TEST(RNG, counterBasedState) {
+  RandomNumberGenerator rng = utils::RNG<double>(uint64_t(99), uint64_t(3));
+  rng();
+  const auto state = rng.getState();
+  const auto r1 = rng();
+  const auto r2 = rng();
+  RandomNumberGenerator other = utils::RNG<double>(5);
+  other.setState(state);
+  EXPECT_EQ(other(), r1);
+  EXPECT_EQ(other(), r2);
+}
+
+TEST(RNG, aliasTable) {
+  const std::vector<double> weights = {0.1, 0.6, 0., 0.3};
+  std::vector<float> probability(weights.size());
+  std::vector<uint8_t> alias(weights.size());
+  utils::buildAliasTable(weights.data(), weights.size(), probability.data(), alias.data());
+  RandomNumberGenerator rng = utils::RNG<double>(7);
+  const size_t N = 1000000;
+  std::vector<size_t> counts(weights.size());
+  for (size_t i = 0; i < N; ++i)
+    counts[utils::sampleAliasTable(rng(), probability.data(), alias.data(), weights.size())]++;
+  for (size_t i = 0; i < weights.size(); ++i)
+    EXPECT_NEAR((double)counts[i] / (double)N, weights[i], 0.002);
+}
+
+TEST(RNG, aliasTableTooLarge) {
+  const std::vector<double> weights(257, 1.);
+  std::vector<float> probability(weights.size());
+  std::vector<uint8_t> alias(weights.size());
+  EXPECT_THROW(
+      utils::buildAliasTable(weights.data(), weights.size(), probability.data(), alias.data()),
+      std::invalid_argument);
+  utils::buildAliasTable(weights.data(), 256, probability.data(), alias.data());
+  EXPECT_EQ(alias[255], 255);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
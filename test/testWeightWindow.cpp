@@ -0,0 +1,55 @@
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "simprop.h"
+
+namespace simprop {
+
+TEST(WeightWindow, rouletteIsUnbiased) {
+  RandomNumberGenerator rng = utils::RNG<double>(1234);
+  evolutors::WeightWindow window;
+  window.add(proton, {1e17 * SI::eV, 1e19 * SI::eV}, 0.5, 2.);
+  const auto Gamma = 1e18 * SI::eV / SI::protonMassC2;
+  size_t N = 1000000;
+  std::vector<Particle> particles(N, Particle(proton, 0.1, Gamma, 0.1));
+  window.apply(particles, rng);
+  double sum = 0;
+  for (const auto& particle : particles) {
+    EXPECT_DOUBLE_EQ(particle.getWeight(), 1.25);
+    sum += particle.getWeight();
+  }
+  EXPECT_LT(particles.size(), N / 10);
+  EXPECT_NEAR(sum / (0.1 * (double)N), 1., 0.01);
+}
+
+TEST(WeightWindow, splittingConservesWeight) {
+  RandomNumberGenerator rng = utils::RNG<double>(5678);
+  evolutors::WeightWindow window(4);
+  window.add(proton, {1e17 * SI::eV, 1e19 * SI::eV}, 0.5, 2.);
+  const auto Gamma = 1e18 * SI::eV / SI::protonMassC2;
+  std::vector<Particle> particles{Particle(proton, 0.1, Gamma, 5.),
+                                  Particle(proton, 0.1, Gamma, 100.)};
+  window.apply(particles, rng);
+  ASSERT_EQ(particles.size(), size_t(7));
+  double sum = 0;
+  for (const auto& particle : particles) sum += particle.getWeight();
+  EXPECT_DOUBLE_EQ(sum, 105.);
+  EXPECT_DOUBLE_EQ(particles[0].getWeight(), 5. / 3.);
+  EXPECT_DOUBLE_EQ(particles[1].getWeight(), 25.);
+}
+
+TEST(WeightWindow, outsideWindows) {
+  RandomNumberGenerator rng = utils::RNG<double>(42);
+  evolutors::WeightWindow window;
+  window.add(proton, {1e17 * SI::eV, 1e19 * SI::eV}, 0.5, 2.);
+  window.add(neutrino_mu, {1e17 * SI::eV, 1e19 * SI::eV}, 0.5, 2.);
+  std::vector<Particle> particles{Particle(proton, 0.1, 1e12, 0.01),
+                                  Particle(neutron, 0.1, 1e9, 0.01),
+                                  Particle(neutrino_mu, 0.1, 1e20 * SI::eV, 0.01)};
+  window.apply(particles, rng);
+  ASSERT_EQ(particles.size(), size_t(3));
+  for (const auto& particle : particles) EXPECT_DOUBLE_EQ(particle.getWeight(), 0.01);
+  EXPECT_THROW(window.add(proton, {1., 2.}, 2., 1.), std::invalid_argument);
+}
+
+}  // namespace simprop